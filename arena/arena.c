@@ -0,0 +1,115 @@
+//  arena.c : partie implantation d'un module d'allocation par région.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+//  Les blocs sont alloués avec une taille initiale de ARENA__BLOCK_MIN octets,
+//    doublée à chaque nouveau bloc sans dépasser ARENA__BLOCK_MAX. Une demande
+//    de plus du quart de cette taille donne lieu à un bloc qui lui est propre,
+//    afin de ne pas perdre la fin du bloc courant.
+
+#define ARENA__BLOCK_MIN ((size_t) 1 << 16)
+#define ARENA__BLOCK_MAX ((size_t) 1 << 24)
+#define ARENA__ALIGN (_Alignof(max_align_t))
+
+//  struct block, block : en-tête d'un bloc, suivi des octets distribués.
+
+typedef struct block block;
+
+struct block {
+  block *next;
+  max_align_t data[];
+};
+
+//  struct arena, arena : le composant head repère la liste des blocs alloués,
+//    le bloc courant en tête. Les octets encore disponibles dans le bloc
+//    courant sont ceux de l'intervalle [free, limit[. Le composant blocksize
+//    mémorise la taille du prochain bloc.
+
+struct arena {
+  block *head;
+  char *free;
+  char *limit;
+  size_t blocksize;
+};
+
+arena *arena_empty(void) {
+  arena *a = malloc(sizeof *a);
+  if (a == NULL) {
+    return NULL;
+  }
+  a->head = NULL;
+  a->free = NULL;
+  a->limit = NULL;
+  a->blocksize = ARENA__BLOCK_MIN;
+  return a;
+}
+
+void arena_dispose(arena **aptr) {
+  if (*aptr == NULL) {
+    return;
+  }
+  block *p = (*aptr)->head;
+  while (p != NULL) {
+    block *t = p;
+    p = p->next;
+    free(t);
+  }
+  free(*aptr);
+  *aptr = NULL;
+}
+
+//  arena__alloc_block : tente d'allouer un bloc d'au moins size octets. Si le
+//    bloc est propre à la demande, il est inséré en deuxième position de la
+//    liste, le bloc courant restant inchangé. Renvoie NULL en cas de
+//    dépassement de capacité, l'adresse des octets du bloc sinon.
+static char *arena__alloc_block(arena *a, size_t size) {
+  int own = size > a->blocksize / 4;
+  size_t n = own ? size : a->blocksize;
+  if (n > SIZE_MAX - sizeof(block)) {
+    return NULL;
+  }
+  block *p = malloc(sizeof(block) + n);
+  if (p == NULL) {
+    return NULL;
+  }
+  char *d = (char *) p->data;
+  if (own && a->head != NULL) {
+    p->next = a->head->next;
+    a->head->next = p;
+    return d;
+  }
+  p->next = a->head;
+  a->head = p;
+  a->free = d;
+  a->limit = d + n;
+  if (!own && a->blocksize < ARENA__BLOCK_MAX) {
+    a->blocksize *= 2;
+  }
+  return d;
+}
+
+char *arena_alloc_char(arena *a, size_t size) {
+  if (size <= (size_t) (a->limit - a->free)) {
+    char *r = a->free;
+    a->free += size;
+    return r;
+  }
+  char *r = arena__alloc_block(a, size);
+  if (r != NULL && r == a->free) {
+    a->free += size;
+  }
+  return r;
+}
+
+void *arena_alloc(arena *a, size_t size) {
+  size_t pad = (size_t) (-(uintptr_t) a->free & (ARENA__ALIGN - 1));
+  if (pad <= (size_t) (a->limit - a->free)) {
+    a->free += pad;
+  }
+  if (size > SIZE_MAX - (ARENA__ALIGN - 1)) {
+    return NULL;
+  }
+  return arena_alloc_char(a, (size + ARENA__ALIGN - 1) & ~(ARENA__ALIGN - 1));
+}
@@ -0,0 +1,46 @@
+//  arena.h : partie interface d'un module d'allocation par région. Une région
+//    distribue des zones mémoire prélevées séquentiellement dans de grands
+//    blocs alloués dynamiquement. Les zones ne sont pas libérées
+//    individuellement : elles le sont toutes à la fois lors de la libération
+//    de la région.
+
+#ifndef ARENA__H
+#define ARENA__H
+
+#include <stdlib.h>
+
+//  Fonctionnement général :
+//  - les fonctions qui possèdent un paramètre de type « arena * » ou
+//      « arena ** » ont un comportement indéterminé lorsque ce paramètre ou sa
+//      déréférence n'est pas l'adresse d'un contrôleur préalablement renvoyée
+//      avec succès par la fonction arena_empty et non révoquée depuis par la
+//      fonction arena_dispose ;
+//  - les zones distribuées par une région restent valides jusqu'à la
+//      libération de celle-ci.
+
+//  struct arena, arena : type et nom de type d'un contrôleur regroupant les
+//    informations nécessaires pour gérer une région.
+typedef struct arena arena;
+
+//  arena_empty : tente d'allouer les ressources nécessaires pour gérer une
+//    nouvelle région initialement vide. Renvoie NULL en cas de dépassement de
+//    capacité. Renvoie sinon un pointeur vers le contrôleur associé à la
+//    région.
+extern arena *arena_empty(void);
+
+//  arena_dispose : sans effet si *aptr vaut NULL. Libère sinon toutes les
+//    zones distribuées par la région associée à *aptr ainsi que les ressources
+//    allouées à sa gestion puis affecte NULL à *aptr.
+extern void arena_dispose(arena **aptr);
+
+//  arena_alloc : tente de prélever une zone de size octets dans la région
+//    associée à a. La zone est convenablement alignée pour tout type d'objet.
+//    Renvoie NULL en cas de dépassement de capacité. Renvoie sinon l'adresse
+//    de la zone.
+extern void *arena_alloc(arena *a, size_t size);
+
+//  arena_alloc_char : identique à arena_alloc, à ceci près que la zone n'est
+//    destinée qu'à des caractères et qu'aucun alignement n'est garanti.
+extern char *arena_alloc_char(arena *a, size_t size);
+
+#endif
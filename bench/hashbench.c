@@ -0,0 +1,163 @@
+//  hashbench.c : micro-banc d'essai comparant l'ancienne fonction de hachage
+//    de lnid, str_hashfun, à hash_bytes sur les lignes des fichiers fournis.
+//
+//  Syntaxe : ./hashbench FILENAME ...
+//
+//  Pour chaque fonction sont affichés le débit de hachage et, pour une table
+//    de 2 ^ k compartiments indicés par les k bits de poids faible comme le fait
+//    le module hashtable et contenant les lignes distinctes, la longueur
+//    maximale d'une liste et le nombre moyen de comparaisons d'une recherche
+//    positive.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hash.h"
+#include "reader.h"
+
+#define ROUNDS 20
+
+typedef struct {
+  const char *s;
+  size_t len;
+} span;
+
+// str_hashfun(s) : ancienne fonction de hashage pour les chaines de caractères
+static size_t str_hashfun(const char *s, size_t len) {
+  size_t h = 0;
+  for (const unsigned char *p = (const unsigned char *) s;
+      p < (const unsigned char *) s + len; p++) {
+    h = 37 * h + *p;
+  }
+  return h;
+}
+
+static size_t seed;
+
+static size_t wy_hashfun(const char *s, size_t len) {
+  return hash_bytes(s, len, seed);
+}
+
+// spancmp(a, b) : compare deux lignes selon leur longueur puis leur contenu.
+static int spancmp(const void *a, const void *b) {
+  const span *x = a;
+  const span *y = b;
+  if (x->len != y->len) {
+    return x->len < y->len ? -1 : 1;
+  }
+  return memcmp(x->s, y->s, x->len);
+}
+
+// bench(name, fun, lines, n, uniq, u) : mesure et affiche les performances de
+//  fun sur les n lignes du tableau lines et sur les u lignes distinctes du
+//  tableau uniq.
+static void bench(const char *name, size_t (*fun)(const char *, size_t),
+    const span *lines, size_t n, const span *uniq, size_t u) {
+  size_t bytes = 0;
+  size_t acc = 0;
+  clock_t t = clock();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (size_t i = 0; i < n; i++) {
+      acc += fun(lines[i].s, lines[i].len);
+      bytes += lines[i].len;
+    }
+  }
+  double secs = (double) (clock() - t) / CLOCKS_PER_SEC;
+  size_t lbm = 0;
+  while (((size_t) 1 << lbm) < u) {
+    lbm++;
+  }
+  size_t m = (size_t) 1 << lbm;
+  size_t *count = calloc(m, sizeof *count);
+  if (count == NULL) {
+    fprintf(stderr, "malloc_error\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < u; i++) {
+    count[fun(uniq[i].s, uniq[i].len) % m]++;
+  }
+  size_t maxlen = 0;
+  double pos = 0.0;
+  for (size_t k = 0; k < m; k++) {
+    if (count[k] > maxlen) {
+      maxlen = count[k];
+    }
+    pos += (double) count[k] * (double) (count[k] + 1) / 2.0;
+  }
+  free(count);
+  printf("%-12s %10.1f Mlines/s %8.1f MB/s   2^%zu slots: max.len %5zu"
+      "  pos.curr %6.3f   (%zx)\n",
+      name, (double) n * ROUNDS / secs / 1e6,
+      (double) bytes / secs / 1e6, lbm, maxlen, u == 0 ? 0.0 : pos / (double) u,
+      acc & 0xf);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Syntax : %s FILENAME ...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  seed = hash_seed();
+  size_t size = 1024;
+  size_t n = 0;
+  span *lines = malloc(size * sizeof *lines);
+  reader **files = malloc((size_t) argc * sizeof *files);
+  if (lines == NULL || files == NULL) {
+    fprintf(stderr, "malloc_error\n");
+    return EXIT_FAILURE;
+  }
+  for (int i = 1; i < argc; i++) {
+    files[i] = reader_open(argv[i]);
+    if (files[i] == NULL) {
+      fprintf(stderr, "file_error : %s\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+    const char *s;
+    size_t len;
+    while (reader_next(files[i], &s, &len) == 1) {
+      const char *k = reader_keep(files[i], s, len);
+      if (k == NULL) {
+        fprintf(stderr, "file_error : %s is not a regular file\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+      if (n == size) {
+        size *= 2;
+        span *t = realloc(lines, size * sizeof *lines);
+        if (t == NULL) {
+          fprintf(stderr, "malloc_error\n");
+          return EXIT_FAILURE;
+        }
+        lines = t;
+      }
+      lines[n] = (span) {
+        .s = k, .len = len
+      };
+      n++;
+    }
+  }
+  span *uniq = malloc((n == 0 ? 1 : n) * sizeof *uniq);
+  if (uniq == NULL) {
+    fprintf(stderr, "malloc_error\n");
+    return EXIT_FAILURE;
+  }
+  memcpy(uniq, lines, n * sizeof *uniq);
+  qsort(uniq, n, sizeof *uniq, spancmp);
+  size_t u = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (u == 0 || spancmp(&uniq[u - 1], &uniq[i]) != 0) {
+      uniq[u] = uniq[i];
+      u++;
+    }
+  }
+  printf("%zu lines, %zu distinct\n", n, u);
+  bench("str_hashfun", str_hashfun, lines, n, uniq, u);
+  bench("hash_bytes", wy_hashfun, lines, n, uniq, u);
+  free(uniq);
+  for (int i = 1; i < argc; i++) {
+    reader_dispose(&files[i]);
+  }
+  free(files);
+  free(lines);
+  return EXIT_SUCCESS;
+}
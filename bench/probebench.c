@@ -0,0 +1,171 @@
+//  probebench.c : micro-banc d'essai mesurant le débit des recherches
+//    positives dans une table de hachage plus grande que le dernier niveau de
+//    cache, effectuées une à une via hashtable_search puis par groupes via
+//    hashtable_search_add_batch, qui annonce les recherches au préalable.
+//
+//  Syntaxe : ./probebench [LBN]
+//
+//  La table contient 2 ^ LBN clés distinctes (2 ^ 21 par défaut), chaines de
+//    16 à 47 caractères. Les recherches portent sur des copies de ces clés,
+//    prises dans un ordre aléatoire et dont les valeurs de hachage sont
+//    calculées au préalable, comme le fait lnid pour un lot de lignes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "arena.h"
+#include "hash.h"
+#include "hashtable.h"
+
+#define ROUNDS 3
+#define LBN_DEFAULT 21
+#define GROUP_MAX 64
+
+typedef struct {
+  const char *s;
+  size_t len;
+  size_t h;
+} span;
+
+// spaneq(a, b) : renvoie zéro si les lignes a et b sont égales, une valeur
+//  non nulle sinon.
+static int spaneq(const void *a, const void *b) {
+  const span *x = a;
+  const span *y = b;
+  return x->len != y->len || memcmp(x->s, y->s, x->len) != 0;
+}
+
+static size_t spanhash(const void *a) {
+  return ((const span *) a)->h;
+}
+
+// seconds() : renvoie la valeur, en secondes, de l'horloge du processus.
+static double seconds(void) {
+  return (double) clock() / CLOCKS_PER_SEC;
+}
+
+// bench(ht, queries, refs, hashes, n, group) : mesure et affiche le débit des
+//  recherches des n clés de queries dans ht, par groupes de group clés, au
+//  plus GROUP_MAX, ou une à une si group vaut 0. refs et hashes sont les
+//  références et les valeurs de hachage des clés de queries.
+static void bench(hashtable *ht, const span *queries, const void **refs,
+    const size_t *hashes, size_t n, size_t group) {
+  void *results[GROUP_MAX];
+  double best = 0.0;
+  size_t found = 0;
+  for (int r = 0; r < ROUNDS; r++) {
+    found = 0;
+    double t = seconds();
+    if (group == 0) {
+      for (size_t i = 0; i < n; i++) {
+        found += hashtable_search(ht, &queries[i]) != NULL;
+      }
+    } else {
+      for (size_t i = 0; i < n; i += group) {
+        size_t m = n - i < group ? n - i : group;
+        hashtable_search_add_batch(ht, refs + i, hashes + i, m, NULL, NULL,
+            results);
+        for (size_t k = 0; k < m; k++) {
+          found += results[k] != NULL;
+        }
+      }
+    }
+    t = seconds() - t;
+    if (r == 0 || t < best) {
+      best = t;
+    }
+  }
+  char name[32];
+  if (group == 0) {
+    snprintf(name, sizeof name, "one by one");
+  } else {
+    snprintf(name, sizeof name, "groups of %zu", group);
+  }
+  printf("%-14s %8.2f Mlines/s  (%zu/%zu found)\n", name,
+      (double) n / best / 1e6, found, n);
+}
+
+int main(int argc, char *argv[]) {
+  size_t lbn = LBN_DEFAULT;
+  if (argc > 2 || (argc == 2 && (lbn = strtoul(argv[1], NULL, 10)) == 0)
+      || lbn > 30) {
+    fprintf(stderr, "Syntax : %s [LBN]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  size_t n = (size_t) 1 << lbn;
+  size_t seed = hash_seed();
+  arena *a = arena_empty();
+  span *keys = malloc(n * sizeof *keys);
+  span *queries = malloc(n * sizeof *queries);
+  size_t *perm = malloc(n * sizeof *perm);
+  const void **refs = malloc(n * sizeof *refs);
+  size_t *hashes = malloc(n * sizeof *hashes);
+  hashtable *ht = hashtable_empty(spaneq, spanhash);
+  if (a == NULL || keys == NULL || queries == NULL || perm == NULL
+      || refs == NULL || hashes == NULL || ht == NULL) {
+    fprintf(stderr, "malloc_error\n");
+    return EXIT_FAILURE;
+  }
+  srand((unsigned) seed);
+  for (size_t i = 0; i < n; i++) {
+    char buf[64];
+    int len = snprintf(buf, sizeof buf, "%0*zx", 16 + (int) (i % 32),
+        i * 0x9e3779b97f4a7c15u);
+    char *s = arena_alloc_char(a, (size_t) len + 1);
+    if (s == NULL) {
+      fprintf(stderr, "malloc_error\n");
+      return EXIT_FAILURE;
+    }
+    memcpy(s, buf, (size_t) len + 1);
+    keys[i] = (span) {
+      .s = s, .len = (size_t) len, .h = hash_bytes(s, (size_t) len, seed)
+    };
+    perm[i] = i;
+  }
+  for (size_t i = n - 1; i > 0; i--) {
+    size_t j = (((size_t) rand() << 16) ^ (size_t) rand()) % (i + 1);
+    size_t t = perm[i];
+    perm[i] = perm[j];
+    perm[j] = t;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (hashtable_add(ht, &keys[perm[i]], &keys[perm[i]]) == NULL) {
+      fprintf(stderr, "malloc_error\n");
+      return EXIT_FAILURE;
+    }
+  }
+  for (size_t i = n - 1; i > 0; i--) {
+    size_t j = (((size_t) rand() << 16) ^ (size_t) rand()) % (i + 1);
+    size_t t = perm[i];
+    perm[i] = perm[j];
+    perm[j] = t;
+  }
+  for (size_t i = 0; i < n; i++) {
+    const span *k = &keys[perm[i]];
+    char *s = arena_alloc_char(a, k->len + 1);
+    if (s == NULL) {
+      fprintf(stderr, "malloc_error\n");
+      return EXIT_FAILURE;
+    }
+    memcpy(s, k->s, k->len + 1);
+    queries[i] = (span) {
+      .s = s, .len = k->len, .h = k->h
+    };
+    refs[i] = &queries[i];
+    hashes[i] = k->h;
+  }
+  printf("%zu keys\n", n);
+  bench(ht, queries, refs, hashes, n, 0);
+  bench(ht, queries, refs, hashes, n, 16);
+  bench(ht, queries, refs, hashes, n, 32);
+  bench(ht, queries, refs, hashes, n, GROUP_MAX);
+  hashtable_dispose(&ht);
+  free(hashes);
+  free(refs);
+  free(perm);
+  free(queries);
+  free(keys);
+  arena_dispose(&a);
+  return EXIT_SUCCESS;
+}
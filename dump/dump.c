@@ -0,0 +1,62 @@
+//  dump.c : lit un résultat de lnid écrit au format binaire, dans le fichier
+//    donné en argument ou sur l'entrée standard, et l'écrit sur la sortie
+//    standard au format texte de lnid.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "output.h"
+#include "report.h"
+
+int main(int argc, char *argv[]) {
+  if (argc > 2) {
+    fprintf(stderr, "Syntax : %s [FILENAME]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  report *r = report_open(argc == 2 ? argv[1] : NULL);
+  if (r == NULL) {
+    fprintf(stderr, "file_error : %s is not a valid lnid report\n",
+        argc == 2 ? argv[1] : "stdin");
+    return EXIT_FAILURE;
+  }
+  output *out = output_open(STDOUT_FILENO);
+  if (out == NULL) {
+    report_dispose(&r);
+    fprintf(stderr,
+        "malloc_error : something went wrong when allocating memory\n");
+    return EXIT_FAILURE;
+  }
+  for (size_t k = 0; k < report_nbfile(r); k++) {
+    output_string(out, report_filename(r, k));
+    output_char(out, '\t');
+  }
+  output_char(out, '\n');
+  int rc;
+  while ((rc = report_next(r)) == 1) {
+    // Comme pour lnid, les numéros de ligne sont séparés par des virgules,
+    //  le dernier étant suivi d'une tabulation, et les nombres d'occurrences
+    //  sont chacun suivis d'une tabulation
+    size_t n = report_nbvalue(r);
+    for (size_t k = 0; k < n; k++) {
+      output_size_t(out, report_value(r, k));
+      output_char(out, report_mode(r) == REPORT_NUMBERS && k + 1 < n
+          ? ',' : '\t');
+    }
+    output_mem(out, report_line(r), report_length(r));
+    output_char(out, '\n');
+  }
+  int err = output_dispose(&out);
+  report_dispose(&r);
+  if (rc != 0) {
+    fprintf(stderr, "file_error : %s is truncated or corrupted\n",
+        argc == 2 ? argv[1] : "stdin");
+    return EXIT_FAILURE;
+  }
+  if (err != 0) {
+    fprintf(stderr, "write_error : something went wrong when writing\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
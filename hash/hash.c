@@ -0,0 +1,126 @@
+//  hash.c : partie implantation d'un module de hachage de zones mémoire.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "hash.h"
+
+//  Constantes de mélange : entiers impairs de 64 bits comportant autant de
+//    bits à 1 que de bits à 0, ceux de wyhash.
+
+#define HASH__S0 0x2d358dccaa6c78a5ULL
+#define HASH__S1 0x8bb84b93962eacc9ULL
+#define HASH__S2 0x4b33a62ed433d4a3ULL
+#define HASH__S3 0x4d5a2da51de1aa47ULL
+
+//  hash__mum : remplace *a et *b respectivement par les 64 bits de poids faible
+//    et les 64 bits de poids fort du produit de *a par *b.
+static inline void hash__mum(uint64_t *a, uint64_t *b) {
+#if defined __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 uint128;
+  uint128 r = (uint128) *a * *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+#else
+  uint64_t ha = *a >> 32;
+  uint64_t la = (uint32_t) *a;
+  uint64_t hb = *b >> 32;
+  uint64_t lb = (uint32_t) *b;
+  uint64_t rh = ha * hb;
+  uint64_t rm0 = ha * lb;
+  uint64_t rm1 = hb * la;
+  uint64_t rl = la * lb;
+  uint64_t t = rl + (rm0 << 32);
+  uint64_t c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+//  hash__mix : renvoie le ou exclusif des deux moitiés du produit de a par b.
+static inline uint64_t hash__mix(uint64_t a, uint64_t b) {
+  hash__mum(&a, &b);
+  return a ^ b;
+}
+
+//  hash__r8, hash__r4, hash__r3 : lectures de 8, 4 et de 1 à 3 octets.
+static inline uint64_t hash__r8(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof v);
+  return v;
+}
+
+static inline uint64_t hash__r4(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof v);
+  return v;
+}
+
+static inline uint64_t hash__r3(const unsigned char *p, size_t k) {
+  return ((uint64_t) p[0] << 16) | ((uint64_t) p[k >> 1] << 8) | p[k - 1];
+}
+
+size_t hash_bytes(const void *p, size_t len, size_t seed) {
+  const unsigned char *q = p;
+  uint64_t s = (uint64_t) seed;
+  s ^= hash__mix(s ^ HASH__S0, HASH__S1);
+  uint64_t a;
+  uint64_t b;
+  if (len <= 16) {
+    if (len >= 4) {
+      size_t k = (len >> 3) << 2;
+      a = (hash__r4(q) << 32) | hash__r4(q + k);
+      b = (hash__r4(q + len - 4) << 32) | hash__r4(q + len - 4 - k);
+    } else if (len > 0) {
+      a = hash__r3(q, len);
+      b = 0;
+    } else {
+      a = 0;
+      b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t s1 = s;
+      uint64_t s2 = s;
+      do {
+        s = hash__mix(hash__r8(q) ^ HASH__S1, hash__r8(q + 8) ^ s);
+        s1 = hash__mix(hash__r8(q + 16) ^ HASH__S2, hash__r8(q + 24) ^ s1);
+        s2 = hash__mix(hash__r8(q + 32) ^ HASH__S3, hash__r8(q + 40) ^ s2);
+        q += 48;
+        i -= 48;
+      } while (i > 48);
+      s ^= s1 ^ s2;
+    }
+    while (i > 16) {
+      s = hash__mix(hash__r8(q) ^ HASH__S1, hash__r8(q + 8) ^ s);
+      q += 16;
+      i -= 16;
+    }
+    a = hash__r8(q + i - 16);
+    b = hash__r8(q + i - 8);
+  }
+  a ^= HASH__S1;
+  b ^= s;
+  hash__mum(&a, &b);
+  return (size_t) hash__mix(a ^ HASH__S0 ^ len, b ^ HASH__S1);
+}
+
+size_t hash_seed(void) {
+  uint64_t s = 0;
+  FILE *f = fopen("/dev/urandom", "rb");
+  if (f != NULL) {
+    if (fread(&s, sizeof s, 1, f) != 1) {
+      s = 0;
+    }
+    fclose(f);
+  }
+  if (s == 0) {
+    s = hash__mix((uint64_t) time(NULL) ^ HASH__S2,
+        (uint64_t) clock() ^ (uint64_t) (uintptr_t) &s);
+  }
+  return (size_t) s;
+}
@@ -0,0 +1,23 @@
+//  hash.h : partie interface d'un module de hachage de zones mémoire.
+
+//  La fonction de hachage traite les données par mots de 64 bits et repose sur
+//    des multiplications 64 × 64 → 128 bits dont les deux moitiés sont
+//    combinées, à la manière de wyhash. Tous les bits du résultat, y compris
+//    ceux de poids faible, dépendent de tous les octets hachés. Le résultat
+//    dépend en outre d'un germe : choisir un germe aléatoire à chaque exécution
+//    empêche de construire à l'avance des données qui provoqueraient de
+//    nombreuses collisions.
+
+#ifndef HASH__H
+#define HASH__H
+
+#include <stdlib.h>
+
+//  hash_seed : renvoie un germe tiré aléatoirement.
+extern size_t hash_seed(void);
+
+//  hash_bytes : renvoie la valeur de hachage, pour le germe seed, des len
+//    octets figurant à partir de l'adresse p.
+extern size_t hash_bytes(const void *p, size_t len, size_t seed);
+
+#endif
@@ -4,6 +4,7 @@
 
 #include <stdint.h>
 #include "hashtable.h"
+#include "arena.h"
 
 //  Le nombre de compartiments du tableau de hachage est une puissance de 2. Il
 //    vaut initialement « 2 ^ HT__LBNSLOTS_MIN ». Dès que le taux de remplissage
@@ -50,7 +51,12 @@
 //    initialisée : 1) tant que le tableau de hachage n'a pas été alloué,
 //    la valeur de hasharray est l'adresse du champ null ; 2) la fonction de
 //    recherche locale hashtable__search est toujours définie car la valeur du
-//    champ null est NULL.
+//    champ null est NULL. Les cellules sont allouées dans la région cells
+//    propre à la table ; les cellules retirées sont chainées dans la liste
+//    repérée par freecells et réutilisées lors des ajouts suivants. Chaque
+//    cellule mémorise la valeur de pré-hachage de sa clé : elle permet de ne
+//    comparer deux clés via compar que si leurs valeurs de pré-hachage sont
+//    égales et d'agrandir le tableau de hachage sans appeler hashfun.
 
 //  L'ajout d'une nouvelle entrée a lieu en queue de liste. L'ordre induit est
 //    respecté lors de tout agrandissement du tableau de hachage.
@@ -58,6 +64,7 @@
 typedef struct cell cell;
 
 struct cell {
+  size_t hashval;
   const void *keyref;
   const void *valref;
   cell *next;
@@ -68,6 +75,8 @@ struct hashtable {
   size_t (*hashfun)(const void *);
   cell **hasharray;
   cell *null;
+  arena *cells;
+  cell *freecells;
   size_t lbnslots;
   size_t nfreeentries;
 };
@@ -78,17 +87,20 @@ struct hashtable {
 #define HALF(k) ((k) >> 1)
 #define POW2(n) ((size_t) 1 << (n))
 
-#define HASHVAL(__hashfun, __lbnslots, __keyref)                               \
-  (__hashfun(__keyref) % POW2(__lbnslots))
+#define HASHVAL(__hashval, __lbnslots)                                         \
+  ((__hashval) % POW2(__lbnslots))
 
 //  hashtable__search : recherche dans la table de hachage associé à ht une clé
-//    égale à keyref au sens de compar. Renvoie l'adresse du pointeur qui repère
-//    la cellule qui contient cette occurrence si elle existe. Renvoie sinon
-//    l'adresse du pointeur qui marque la fin de la liste.
-static cell **hashtable__search(const hashtable *ht, const void *keyref) {
-  size_t k = HASHVAL(ht->hashfun, ht->lbnslots, keyref);
+//    égale à keyref au sens de compar et de valeur de pré-hachage h. Renvoie
+//    l'adresse du pointeur qui repère la cellule qui contient cette occurrence
+//    si elle existe. Renvoie sinon l'adresse du pointeur qui marque la fin de
+//    la liste.
+static cell **hashtable__search(const hashtable *ht, const void *keyref,
+    size_t h) {
+  size_t k = HASHVAL(h, ht->lbnslots);
   cell * const *pp = &ht->hasharray[k];
-  while (*pp != NULL && ht->compar(keyref, (*pp)->keyref) != 0) {
+  while (*pp != NULL
+      && ((*pp)->hashval != h || ht->compar(keyref, (*pp)->keyref) != 0)) {
     pp = &(*pp)->next;
   }
   return (cell **) pp;
@@ -133,7 +145,7 @@ static int hashtable__add_enlarge(hashtable *ht) {
       cell **pp_ = &a[k_];
       cell **pp = &a[k_ + m_];
       while (*pp_ != NULL) {
-        if (HASHVAL(ht->hashfun, lbm, (*pp_)->keyref) < m_) {
+        if (HASHVAL((*pp_)->hashval, lbm) < m_) {
           pp_ = &(*pp_)->next;
         } else {
           *pp = *pp_;
@@ -158,6 +170,12 @@ hashtable *hashtable_empty(int (*compar)(const void *, const void *),
   if (ht == NULL) {
     return NULL;
   }
+  ht->cells = arena_empty();
+  if (ht->cells == NULL) {
+    free(ht);
+    return NULL;
+  }
+  ht->freecells = NULL;
   ht->compar = compar;
   ht->hashfun = hashfun;
   HT__MAKE_BLANK(ht);
@@ -172,41 +190,43 @@ void hashtable_dispose(hashtable **htptr) {
     return;
   }
   if (!HT__IS_BLANK(*htptr)) {
-    size_t m = POW2((*htptr)->lbnslots);
-    for (size_t k = 0; k < m; ++k) {
-      cell *p = (*htptr)->hasharray[k];
-      while (p != NULL) {
-        cell *t = p;
-        p = p->next;
-        free(t);
-      }
-    }
     free((*htptr)->hasharray);
   }
+  arena_dispose(&(*htptr)->cells);
   free(*htptr);
   *htptr = NULL;
 }
 
-void *hashtable_add(hashtable *ht, const void *keyref, const void *valref) {
-  if (valref == NULL) {
-    return NULL;
-  }
-  cell **pp = hashtable__search(ht, keyref);
-  if (*pp != NULL) {
-    const void *r = (*pp)->valref;
-    (*pp)->valref = valref;
-    return (void *) r;
+//  hashtable__new_cell : tente de fournir une cellule, recyclée si possible.
+//    Renvoie NULL en cas de dépassement de capacité, l'adresse de la cellule
+//    sinon.
+static cell *hashtable__new_cell(hashtable *ht) {
+  cell *p = ht->freecells;
+  if (p != NULL) {
+    ht->freecells = p->next;
+    return p;
   }
+  return arena_alloc(ht->cells, sizeof *p);
+}
+
+//  hashtable__insert : ajoute le couple (keyref, valref) de valeur de
+//    pré-hachage h, dont la clé est supposée absente, à la table de hachage
+//    associée à ht ; pp est l'adresse du pointeur qui marque la fin de la liste
+//    que renvoie hashtable__search pour cette clé. Renvoie NULL en cas de
+//    dépassement de capacité, valref sinon.
+static void *hashtable__insert(hashtable *ht, cell **pp, size_t h,
+    const void *keyref, const void *valref) {
   if (ht->nfreeentries == 0) {
     if (hashtable__add_enlarge(ht) != 0) {
       return NULL;
     }
-    pp = hashtable__search(ht, keyref);
+    pp = hashtable__search(ht, keyref, h);
   }
-  cell *p = malloc(sizeof *p);
+  cell *p = hashtable__new_cell(ht);
   if (p == NULL) {
     return NULL;
   }
+  p->hashval = h;
   p->keyref = keyref;
   p->valref = valref;
   p->next = *pp;
@@ -215,21 +235,71 @@ void *hashtable_add(hashtable *ht, const void *keyref, const void *valref) {
   return (void *) valref;
 }
 
+void *hashtable_add(hashtable *ht, const void *keyref, const void *valref) {
+  if (valref == NULL) {
+    return NULL;
+  }
+  size_t h = ht->hashfun(keyref);
+  cell **pp = hashtable__search(ht, keyref, h);
+  if (*pp != NULL) {
+    const void *r = (*pp)->valref;
+    (*pp)->valref = valref;
+    return (void *) r;
+  }
+  return hashtable__insert(ht, pp, h, keyref, valref);
+}
+
+size_t hashtable_search_add_batch(hashtable *ht,
+    const void * const *keyrefs, const size_t *hashvals, size_t n,
+    void *(*make)(void *context, size_t k), void *context, void **results) {
+  for (size_t k = 0; k < n; k++) {
+    __builtin_prefetch(&ht->hasharray[HASHVAL(hashvals[k], ht->lbnslots)]);
+  }
+  for (size_t k = 0; k < n; k++) {
+    const cell *p = ht->hasharray[HASHVAL(hashvals[k], ht->lbnslots)];
+    if (p != NULL) {
+      __builtin_prefetch(p);
+    }
+  }
+  for (size_t k = 0; k < n; k++) {
+    const cell *p = ht->hasharray[HASHVAL(hashvals[k], ht->lbnslots)];
+    if (p != NULL && p->hashval == hashvals[k]) {
+      __builtin_prefetch(p->keyref);
+    }
+  }
+  for (size_t k = 0; k < n; k++) {
+    cell **pp = hashtable__search(ht, keyrefs[k], hashvals[k]);
+    if (*pp != NULL) {
+      results[k] = (void *) (*pp)->valref;
+    } else if (make == NULL) {
+      results[k] = NULL;
+    } else {
+      void *r = make(context, k);
+      if (r == NULL || hashtable__insert(ht, pp, hashvals[k], r, r) == NULL) {
+        return k;
+      }
+      results[k] = r;
+    }
+  }
+  return n;
+}
+
 void *hashtable_remove(hashtable *ht, const void *keyref) {
-  cell **pp = hashtable__search(ht, keyref);
+  cell **pp = hashtable__search(ht, keyref, ht->hashfun(keyref));
   if (*pp == NULL) {
     return NULL;
   }
   cell *p = *pp;
   const void *r = p->valref;
   *pp = p->next;
-  free(p);
+  p->next = ht->freecells;
+  ht->freecells = p;
   ht->nfreeentries += 1;
   return (void *) r;
 }
 
 void *hashtable_search(hashtable *ht, const void *keyref) {
-  const cell *p = *hashtable__search(ht, keyref);
+  const cell *p = *hashtable__search(ht, keyref, ht->hashfun(keyref));
   return p == NULL ? NULL : (void *) p->valref;
 }
 
@@ -74,6 +74,26 @@ extern void *hashtable_remove(hashtable *ht, const void *keyref);
 //    référence de la valeur correspondante sinon.
 extern void *hashtable_search(hashtable *ht, const void *keyref);
 
+//  hashtable_search_add_batch : effectue, pour k allant de 0 à n - 1, la
+//    recherche dans la table de hachage associée à ht de la référence d'une clé
+//    égale à celle de référence keyrefs[k], hashvals[k] étant la valeur que
+//    renverrait la fonction de pré-hachage pour keyrefs[k]. Si la recherche est
+//    positive, affecte à results[k] la référence de la valeur correspondante.
+//    Sinon, si make vaut NULL, affecte NULL à results[k] ; si make ne vaut pas
+//    NULL, obtient la référence r renvoyée par make(context, k) puis tente
+//    d'ajouter le couple (r, r) à la table et affecte r à results[k] ; il est
+//    supposé que la clé de référence r est égale à celle de référence
+//    keyrefs[k]. Les recherches se font dans l'ordre : une clé qui figure
+//    plusieurs fois dans le lot n'est ajoutée qu'une fois. Renvoie le nombre n
+//    de clés traitées, ou l'indice k de la clé pour laquelle make a renvoyé
+//    NULL ou un dépassement de capacité est survenu. Les recherches sont
+//    annoncées ensemble au préalable, si bien que le lot est traité plus
+//    rapidement que clé par clé lorsque la table dépasse les caches et que n
+//    est de l'ordre de quelques dizaines.
+extern size_t hashtable_search_add_batch(hashtable *ht,
+    const void * const *keyrefs, const size_t *hashvals, size_t n,
+    void *(*make)(void *context, size_t k), void *context, void **results);
+
 #if defined HASHTABLE_STATS && HASHTABLE_STATS != 0
 
 #include <stdio.h>
@@ -0,0 +1,338 @@
+//  hashtable_oa.c : partie implantation d'un module polymorphe pour la
+//    spécification TABLE du TDA Table(T, T') dans le cas d'une table de hachage
+//    par adressage ouvert. Cette implantation peut remplacer hashtable.c : elle
+//    partage son interface hashtable.h.
+
+//  La résolution des collisions se fait par sondage linéaire selon la
+//    stratégie dite « Robin Hood » : lors d'un ajout, une entrée plus proche de
+//    son compartiment d'origine que l'entrée à placer lui cède sa place. Les
+//    distances à l'origine restent ainsi faibles et homogènes, et une recherche
+//    négative peut s'arrêter dès qu'elle rencontre une entrée plus proche de son
+//    origine que la clé cherchée. Le retrait décale vers l'arrière les entrées
+//    qui suivent, sans laisser de marque de suppression.
+
+//  Chaque compartiment mémorise la valeur de pré-hachage de sa clé. Elle sert
+//    d'une part à ne comparer deux clés via compar que si leurs valeurs de
+//    pré-hachage sont égales, d'autre part à ce que l'agrandissement du
+//    tableau n'appelle jamais hashfun.
+
+#include <stdint.h>
+#include "hashtable.h"
+
+//  Le nombre de compartiments du tableau de hachage est une puissance de 2. Il
+//    vaut initialement « 2 ^ HT__LBNSLOTS_MIN ». Dès que le taux de remplissage
+//    de la table de hachage est strictement supérieur à
+//    « (double) HT__LDFACT_MAX_NUMER / (double) HT__LDFACT_MAX_DENOM », le
+//    nombre de compartiments est multiplié par 2. Le seuil doit être
+//    strictement inférieur à 1.
+
+#define HT__LBNSLOTS_MIN      6
+#define HT__LDFACT_MAX_NUMER  7
+#define HT__LDFACT_MAX_DENOM  8
+
+#define HT__NSLOTS_MIN \
+  (1ULL << HT__LBNSLOTS_MIN)
+#define HT__NENTRIESMAX_MIN \
+  (HT__NSLOTS_MIN / HT__LDFACT_MAX_DENOM * HT__LDFACT_MAX_NUMER)
+
+#if HT__LBNSLOTS_MIN < 0                                                       \
+  || HT__LDFACT_MAX_NUMER < 0                                                  \
+  || HT__LDFACT_MAX_DENOM < 1                                                  \
+  || HT__LDFACT_MAX_NUMER >= HT__LDFACT_MAX_DENOM                              \
+  || HT__NSLOTS_MIN == 0                                                       \
+  || HT__NSLOTS_MIN > SIZE_MAX                                                 \
+  || HT__NENTRIESMAX_MIN == 0
+#error Bad choice of HT__ constants.
+#endif
+
+#undef HT__NSLOTS_MIN
+#undef HT__NENTRIESMAX_MIN
+
+//  struct hashtable, hashtable : gestion de l'adressage ouvert. Le composant
+//    compar mémorise la fonction de comparaison des clés, hashfun, leur
+//    fonction de pré-hachage. Le tableau de compartiments est alloué
+//    dynamiquement ; son adresse et le logarithme binaire de sa longueur sont
+//    mémorisés par les composants slots et lbnslots. Le composant nfreeentries
+//    a la même signification que pour le chainage séparé. Un compartiment est
+//    libre si et seulement si son composant valref vaut NULL. Tant que le
+//    tableau n'a pas été alloué, slots vaut NULL.
+
+typedef struct slot slot;
+
+struct slot {
+  size_t hashval;
+  const void *keyref;
+  const void *valref;
+};
+
+struct hashtable {
+  int (*compar)(const void *, const void *);
+  size_t (*hashfun)(const void *);
+  slot *slots;
+  size_t lbnslots;
+  size_t nfreeentries;
+};
+
+#define POW2(n) ((size_t) 1 << (n))
+#define MASK(ht) (POW2((ht)->lbnslots) - 1)
+
+//  DIST : distance entre le compartiment d'indice k et le compartiment
+//    d'origine d'une clé de valeur de pré-hachage h.
+#define DIST(ht, h, k) (((k) - ((h) & MASK(ht))) & MASK(ht))
+
+//  hashtable__search : recherche dans la table de hachage associée à ht une clé
+//    égale à keyref au sens de compar et de valeur de pré-hachage h. Renvoie
+//    l'indice du compartiment qui la contient si elle existe. Renvoie sinon
+//    l'indice du compartiment où elle devrait être placée, et affecte la
+//    distance correspondante à *distptr. Le tableau est supposé alloué.
+static size_t hashtable__search(const hashtable *ht, const void *keyref,
+    size_t h, size_t *distptr) {
+  size_t mask = MASK(ht);
+  size_t k = h & mask;
+  size_t d = 0;
+  while (1) {
+    const slot *p = &ht->slots[k];
+    if (p->valref == NULL || DIST(ht, p->hashval, k) < d) {
+      *distptr = d;
+      return k;
+    }
+    if (p->hashval == h && ht->compar(keyref, p->keyref) == 0) {
+      *distptr = SIZE_MAX;
+      return k;
+    }
+    k = (k + 1) & mask;
+    ++d;
+  }
+}
+
+//  hashtable__place : place l'entrée e dans le tableau de la table de hachage
+//    associée à ht à partir du compartiment d'indice k, l'entrée étant à la
+//    distance d de son origine, en décalant si besoin les entrées suivantes.
+static void hashtable__place(hashtable *ht, slot e, size_t k, size_t d) {
+  size_t mask = MASK(ht);
+  while (ht->slots[k].valref != NULL) {
+    size_t dk = DIST(ht, ht->slots[k].hashval, k);
+    if (dk < d) {
+      slot t = ht->slots[k];
+      ht->slots[k] = e;
+      e = t;
+      d = dk;
+    }
+    k = (k + 1) & mask;
+    ++d;
+  }
+  ht->slots[k] = e;
+}
+
+//  hashtable__add_enlarge : initialise ou agrandit le tableau de la table de
+//    hachage associée à ht. Les entrées sont replacées selon leur valeur de
+//    pré-hachage mémorisée. Renvoie une valeur non nulle en cas de dépassement
+//    de capacité. Renvoie sinon zéro.
+static int hashtable__add_enlarge(hashtable *ht) {
+  size_t lbm = (ht->slots == NULL ? HT__LBNSLOTS_MIN : ht->lbnslots + 1);
+  size_t m = POW2(lbm);
+  slot *a;
+  if (m > SIZE_MAX / sizeof *a
+      || (a = malloc(m * sizeof *a)) == NULL) {
+    return -1;
+  }
+  for (size_t k = 0; k < m; ++k) {
+    a[k].valref = NULL;
+  }
+  slot *old = ht->slots;
+  size_t m_ = (old == NULL ? 0 : POW2(ht->lbnslots));
+  ht->slots = a;
+  ht->lbnslots = lbm;
+  for (size_t k = 0; k < m_; ++k) {
+    if (old[k].valref != NULL) {
+      size_t h = old[k].hashval & MASK(ht);
+      hashtable__place(ht, old[k], h, 0);
+    }
+  }
+  free(old);
+  ht->nfreeentries
+    = m / HT__LDFACT_MAX_DENOM * HT__LDFACT_MAX_NUMER
+      - m_ / HT__LDFACT_MAX_DENOM * HT__LDFACT_MAX_NUMER;
+  return 0;
+}
+
+hashtable *hashtable_empty(int (*compar)(const void *, const void *),
+    size_t (*hashfun)(const void *)) {
+  hashtable *ht = malloc(sizeof *ht);
+  if (ht == NULL) {
+    return NULL;
+  }
+  ht->compar = compar;
+  ht->hashfun = hashfun;
+  ht->slots = NULL;
+  ht->lbnslots = 0;
+  ht->nfreeentries = 0;
+  return ht;
+}
+
+void hashtable_dispose(hashtable **htptr) {
+  if (*htptr == NULL) {
+    return;
+  }
+  free((*htptr)->slots);
+  free(*htptr);
+  *htptr = NULL;
+}
+
+void *hashtable_add(hashtable *ht, const void *keyref, const void *valref) {
+  if (valref == NULL) {
+    return NULL;
+  }
+  size_t h = ht->hashfun(keyref);
+  size_t d = 0;
+  size_t k = 0;
+  if (ht->slots != NULL) {
+    k = hashtable__search(ht, keyref, h, &d);
+    if (d == SIZE_MAX) {
+      const void *r = ht->slots[k].valref;
+      ht->slots[k].valref = valref;
+      return (void *) r;
+    }
+  }
+  if (ht->nfreeentries == 0) {
+    if (hashtable__add_enlarge(ht) != 0) {
+      return NULL;
+    }
+    k = hashtable__search(ht, keyref, h, &d);
+  }
+  hashtable__place(ht, (slot) {
+    .hashval = h, .keyref = keyref, .valref = valref
+  }, k, d);
+  ht->nfreeentries -= 1;
+  return (void *) valref;
+}
+
+void *hashtable_remove(hashtable *ht, const void *keyref) {
+  if (ht->slots == NULL) {
+    return NULL;
+  }
+  size_t d;
+  size_t k = hashtable__search(ht, keyref, ht->hashfun(keyref), &d);
+  if (d != SIZE_MAX) {
+    return NULL;
+  }
+  const void *r = ht->slots[k].valref;
+  size_t mask = MASK(ht);
+  size_t j = (k + 1) & mask;
+  while (ht->slots[j].valref != NULL
+      && DIST(ht, ht->slots[j].hashval, j) != 0) {
+    ht->slots[k] = ht->slots[j];
+    k = j;
+    j = (j + 1) & mask;
+  }
+  ht->slots[k].valref = NULL;
+  ht->nfreeentries += 1;
+  return (void *) r;
+}
+
+size_t hashtable_search_add_batch(hashtable *ht,
+    const void * const *keyrefs, const size_t *hashvals, size_t n,
+    void *(*make)(void *context, size_t k), void *context, void **results) {
+  for (size_t k = 0; ht->slots != NULL && k < n; k++) {
+    __builtin_prefetch(&ht->slots[hashvals[k] & MASK(ht)]);
+  }
+  for (size_t k = 0; ht->slots != NULL && k < n; k++) {
+    const slot *p = &ht->slots[hashvals[k] & MASK(ht)];
+    if (p->valref != NULL && p->hashval == hashvals[k]) {
+      __builtin_prefetch(p->keyref);
+    }
+  }
+  for (size_t k = 0; k < n; k++) {
+    size_t d = 0;
+    size_t j = 0;
+    if (ht->slots != NULL) {
+      j = hashtable__search(ht, keyrefs[k], hashvals[k], &d);
+      if (d == SIZE_MAX) {
+        results[k] = (void *) ht->slots[j].valref;
+        continue;
+      }
+    }
+    if (make == NULL) {
+      results[k] = NULL;
+      continue;
+    }
+    if (ht->nfreeentries == 0) {
+      if (hashtable__add_enlarge(ht) != 0) {
+        return k;
+      }
+      j = hashtable__search(ht, keyrefs[k], hashvals[k], &d);
+    }
+    void *r = make(context, k);
+    if (r == NULL) {
+      return k;
+    }
+    hashtable__place(ht, (slot) {
+      .hashval = hashvals[k], .keyref = r, .valref = r
+    }, j, d);
+    ht->nfreeentries -= 1;
+    results[k] = r;
+  }
+  return n;
+}
+
+void *hashtable_search(hashtable *ht, const void *keyref) {
+  if (ht->slots == NULL) {
+    return NULL;
+  }
+  size_t d;
+  size_t k = hashtable__search(ht, keyref, ht->hashfun(keyref), &d);
+  return d == SIZE_MAX ? (void *) ht->slots[k].valref : NULL;
+}
+
+#if defined HASHTABLE_STATS && HASHTABLE_STATS != 0
+
+//  Pour l'adressage ouvert, la longueur d'une « liste » est la longueur du
+//    sondage qui mène à une clé, autrement dit sa distance à l'origine plus 1.
+//    La valeur théorique est celle du sondage linéaire.
+
+void hashtable_get_stats(hashtable *ht,
+    struct hashtable_stats *htsptr) {
+  size_t m = (ht->slots == NULL ? 0 : POW2(ht->lbnslots));
+  size_t n = m / HT__LDFACT_MAX_DENOM * HT__LDFACT_MAX_NUMER - ht->nfreeentries;
+  size_t g = 0;
+  double s = 0.0;
+  for (size_t k = 0; k < m; ++k) {
+    if (ht->slots[k].valref != NULL) {
+      size_t f = DIST(ht, ht->slots[k].hashval, k) + 1;
+      if (f > g) {
+        g = f;
+      }
+      s += (double) f;
+    }
+  }
+  double r = (double) n / (double) m;
+  *htsptr = (struct hashtable_stats) {
+    .nslots = m,
+    .nentries = n,
+    .ldfactmax = (double) HT__LDFACT_MAX_NUMER / (double) HT__LDFACT_MAX_DENOM,
+    .ldfactcurr = r,
+    .maxlen = g,
+    .postheo = (n == 0 ? 0.0 : (1.0 + 1.0 / (1.0 - r)) / 2.0),
+    .poscurr = s / (double) n,
+  };
+}
+
+#define P_TITLE(textstream, name) \
+  fprintf(textstream, "--- Info: %s\n", name)
+#define P_VALUE(textstream, name, format, value) \
+  fprintf(textstream, "%12s\t" format "\n", name, value)
+
+int hashtable_fprint_stats(hashtable *ht, FILE *textstream) {
+  struct hashtable_stats hts;
+  hashtable_get_stats(ht, &hts);
+  return 0 > P_TITLE(textstream, "Hashtable stats")
+    || 0 > P_VALUE(textstream, "n.slots", "%zu", hts.nslots)
+    || 0 > P_VALUE(textstream, "n.entries", "%zu", hts.nentries)
+    || 0 > P_VALUE(textstream, "ld.fact.max", "%lf", hts.ldfactmax)
+    || 0 > P_VALUE(textstream, "ld.fact.curr", "%lf", hts.ldfactcurr)
+    || 0 > P_VALUE(textstream, "max.len", "%zu", hts.maxlen)
+    || 0 > P_VALUE(textstream, "pos.theo", "%lf", hts.postheo)
+    || 0 > P_VALUE(textstream, "pos.curr", "%lf", hts.poscurr);
+}
+
+#endif
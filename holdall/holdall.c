@@ -1,9 +1,12 @@
 //  Partie implantation du module holdall.
 
 #include "holdall.h"
+#include "arena.h"
 
 //  struct holdall, holdall : implantation par liste dynamique simplement
-//    chainée.
+//    chainée. Les cellules de la liste sont allouées dans une région propre au
+//    fourretout, mémorisée par le composant cells : elles sont toutes libérées
+//    d'un coup lors de la libération du fourretout.
 
 //  Si la macroconstante HOLDALL_PUT_TAIL est définie et que sa macro-évaluation
 //    donne une entier non nul, l'insertion dans la liste a lieu en queue. Dans
@@ -17,6 +20,7 @@ struct choldall {
 };
 
 struct holdall {
+  arena *cells;
   choldall *head;
 #if defined HOLDALL_PUT_TAIL && HOLDALL_PUT_TAIL != 0
   choldall **tailptr;
@@ -29,6 +33,11 @@ holdall *holdall_empty(void) {
   if (ha == NULL) {
     return NULL;
   }
+  ha->cells = arena_empty();
+  if (ha->cells == NULL) {
+    free(ha);
+    return NULL;
+  }
   ha->head = NULL;
 #if defined HOLDALL_PUT_TAIL && HOLDALL_PUT_TAIL != 0
   ha->tailptr = &ha->head;
@@ -41,18 +50,13 @@ void holdall_dispose(holdall **haptr) {
   if (*haptr == NULL) {
     return;
   }
-  choldall *p = (*haptr)->head;
-  while (p != NULL) {
-    choldall *t = p;
-    p = p->next;
-    free(t);
-  }
+  arena_dispose(&(*haptr)->cells);
   free(*haptr);
   *haptr = NULL;
 }
 
 int holdall_put(holdall *ha, void *ref) {
-  choldall *p = malloc(sizeof *p);
+  choldall *p = arena_alloc(ha->cells, sizeof *p);
   if (p == NULL) {
     return -1;
   }
@@ -0,0 +1,796 @@
+//  ingest.c : partie implantation d'un module de lecture des fichiers de lnid
+//    et d'ajout de leurs lignes à une table partagée.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "ingest.h"
+#include "arena.h"
+#include "hash.h"
+#include "hashtable.h"
+#include "holdall.h"
+#include "line.h"
+#include "spsc.h"
+
+//  Longueur minimale des parties d'un fichier lues par des fils d'exécution
+//    différents.
+#define INGEST__CHUNK_MIN (1 << 20)
+
+//  Nombre de lots en circulation entre les deux étapes du pipeline, nombre
+//    maximal de clés d'un lot et taille initiale de son texte.
+#define INGEST__PIPELINE_BATCHES 8
+#define INGEST__BATCH_KEYS 4096
+#define INGEST__BATCH_TEXT (1 << 18)
+
+//  Nombre de fois qu'une étape du pipeline qui attend l'autre lui cède la main
+//    avant de s'endormir.
+#define INGEST__PIPELINE_SPINS 64
+
+//  Nombre maximal de clés d'une même partie de la table dont les recherches
+//    sont confiées ensemble à hashtable_search_add_batch.
+#define INGEST__PREFETCH_GROUP 32
+
+//  struct source, source : lignes lues par r, qui appartiennent au fichier
+//    d'indice i, à reporter dans la table st, la première portant le numéro
+//    first. Si insert vaut 0, les lignes absentes de st sont ignorées ; le sont
+//    également celles présentes dans moins de nbdone fichiers.
+typedef struct {
+  shtable *st;
+  reader *r;
+  size_t i;
+  size_t first;
+  int insert;
+  size_t nbdone;
+} source;
+
+//  struct token, token : clé key de longueur length et de valeur de hachage
+//    hashval, issue de la ligne numéro lnum. Si keep vaut 1, key est exactement
+//    la ligne lue.
+typedef struct {
+  char *key;
+  size_t length;
+  size_t hashval;
+  size_t lnum;
+  int keep;
+} token;
+
+//  struct batch, batch : lot des count clés de tokens, issues de lines lignes
+//    lues totalisant bytes caractères, les lignes vides n'ayant pas de clé. Les
+//    clés qui ne sont pas la ligne lue en place sont recopiées dans le tampon
+//    text de taille text_size, dont text_length caractères sont utilisés.
+typedef struct {
+  token tokens[INGEST__BATCH_KEYS];
+  size_t count;
+  size_t lines;
+  size_t bytes;
+  char *text;
+  size_t text_length;
+  size_t text_size;
+} batch;
+
+//  struct worker, worker : ressources propres à un fil d'exécution : le lot de
+//    clés b ; le tableau order, de longueur INGEST__BATCH_KEYS, des indices
+//    des clés d'un lot regroupées par partie de la table, et le tableau bucket
+//    de longueur nbshard + 1 qui sert à les regrouper ; pour chacune des clés
+//    d'un groupe confié à hashtable_search_add_batch, sa clé t[k], sa ligne de
+//    travail l[k], allouée dans la région a, sa référence keys[k], sa valeur de
+//    hachage hashes[k] et la référence res[k] obtenue.
+typedef struct {
+  batch *b;
+  size_t *order;
+  size_t *bucket;
+  size_t nbshard;
+  arena *a;
+  const token *t[INGEST__PREFETCH_GROUP];
+  line *l[INGEST__PREFETCH_GROUP];
+  const void *keys[INGEST__PREFETCH_GROUP];
+  size_t hashes[INGEST__PREFETCH_GROUP];
+  void *res[INGEST__PREFETCH_GROUP];
+} worker;
+
+//  struct maker, maker : contexte de la fonction ingest__make_line. Les lignes
+//    de travail de w, de valeur celle de la ligne lue dans le fichier associé
+//    à r après transformation éventuelle, sont à recopier dans la région a et
+//    le fourre-tout ha.
+typedef struct {
+  arena *a;
+  holdall *ha;
+  reader *r;
+  const worker *w;
+  size_t nbfilemax;
+} maker;
+
+//  struct tokenizer, tokenizer : état du découpage en clés des lignes de src.
+//    lnum est le numéro de la prochaine ligne. Si copy vaut 1, les clés sont
+//    recopiées dans le texte des lots. Si pending vaut 1, la ligne s de
+//    longueur length, déjà lue, n'a pas encore été découpée. eof passe à 1 une
+//    fois la fin du fichier atteinte.
+typedef struct {
+  const source *src;
+  size_t lnum;
+  int copy;
+  int pending;
+  int eof;
+  const char *s;
+  size_t length;
+} tokenizer;
+
+//  struct producer, producer : contexte de l'étape de lecture du pipeline de g,
+//    qui lit les lignes de src, les transforme, les hache et transmet les clés
+//    obtenues par lots : les lots vides sont défilés de empty, les lots remplis
+//    enfilés dans full. done passe à 1 une fois le dernier lot enfilé, error
+//    mémorise alors l'erreur éventuelle et nbline le nombre de lignes lues.
+//    counters sont les compteurs de l'étape. events, modifié sous la
+//    protection de mutex, est incrémenté à chaque lot enfilé par l'une ou
+//    l'autre étape et au passage de done à 1 ; une étape qui attend l'autre
+//    s'endort sur cond jusqu'à ce qu'il change.
+typedef struct {
+  ingest *g;
+  const source *src;
+  spsc *full;
+  spsc *empty;
+  atomic_int done;
+  atomic_size_t events;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int error;
+  size_t nbline;
+  stage counters;
+} producer;
+
+//  struct ingest_chunk : partie r du premier fichier traité de g, dont les
+//    lignes, numérotées à partir de 1, sont ajoutées à la table st propre à la
+//    partie. nbline est le nombre de lignes lues, error l'erreur éventuelle et
+//    started indique si un fil d'exécution a été créé pour la lire.
+struct ingest_chunk {
+  ingest *g;
+  reader *r;
+  shtable *st;
+  size_t nbline;
+  int error;
+  int started;
+};
+
+//  struct merger, merger : contexte de ingest__merge_line : table st dans
+//    laquelle les lignes d'une partie sont reportées, leurs numéros étant
+//    augmentés de offset.
+typedef struct {
+  shtable *st;
+  size_t offset;
+} merger;
+
+//  ingest__lptr_hfun, ingest__lptreq : fonctions de hachage et de comparaison
+//    des éléments de la table, pointeurs vers des pointeurs de line. La seconde
+//    renvoie 0 si les valeurs des lignes ont même longueur et même contenu, une
+//    valeur non nulle sinon.
+static size_t ingest__lptr_hfun(const void *a) {
+  return line_hash(*(line **) a);
+}
+
+static int ingest__lptreq(const void *a, const void *b) {
+  line *la = *(line **) a;
+  line *lb = *(line **) b;
+  return line_length(la) != line_length(lb)
+    || memcmp(line_value(la), line_value(lb), line_length(la)) != 0;
+}
+
+//  ingest__context_self : renvoie context.
+static void *ingest__context_self(void *context, void *ref) {
+  (void) ref;
+  return context;
+}
+
+//  ingest__now : renvoie la valeur, en secondes, d'une horloge monotone.
+static double ingest__now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+//  ingest__transform : écrit dans dest, de longueur au moins length + 1, la
+//    chaîne obtenue en appliquant à la ligne s de longueur length les options
+//    upp et filter de g. Renvoie sa longueur.
+static size_t ingest__transform(ingest *g, const char *s, size_t length,
+    char *dest) {
+  size_t n = 0;
+  for (size_t k = 0; k < length; k++) {
+    int c = (unsigned char) s[k];
+    if (g->upp == 1) {
+      c = toupper(c);
+    }
+    if (g->filter == NULL || g->filter(c) != 0) {
+      dest[n] = (char) c;
+      n++;
+    }
+  }
+  dest[n] = '\0';
+  return n;
+}
+
+//  ingest__make_line : tente de créer dans la région de context, de type
+//    maker *, une copie de la ligne de travail d'indice k de context, qui
+//    conserve sa valeur en place si possible, c'est-à-dire si sa clé est
+//    exactement la ligne lue, puis de l'ajouter au fourre-tout de context.
+//    Renvoie NULL en cas de dépassement de capacité, l'adresse d'un pointeur
+//    vers la copie sinon.
+static void *ingest__make_line(void *context, size_t k) {
+  maker *m = context;
+  line *l = m->w->l[k];
+  size_t len = line_length(l);
+  const char *s = NULL;
+  if (m->w->t[k]->keep) {
+    s = reader_keep(m->r, line_value(l), len);
+  }
+  if (s == NULL) {
+    char *t = arena_alloc_char(m->a, len);
+    if (t == NULL) {
+      return NULL;
+    }
+    memcpy(t, line_value(l), len);
+    s = t;
+  }
+  line *t = line_empty(m->a, s, len, line_hash(l), m->nbfilemax);
+  line **res = arena_alloc(m->a, sizeof *res);
+  if (t == NULL || res == NULL) {
+    return NULL;
+  }
+  *res = t;
+  if (holdall_put(m->ha, res) != 0) {
+    return NULL;
+  }
+  return res;
+}
+
+//  ingest__worker_init : tente d'allouer les ressources de w pour une table de
+//    nbshard parties dont les lignes figurent dans au plus nbfilemax fichiers.
+//    Renvoie une valeur non nulle en cas de dépassement de capacité, zéro
+//    sinon.
+static int ingest__worker_init(worker *w, size_t nbfilemax, size_t nbshard) {
+  w->b = malloc(sizeof *w->b);
+  w->order = malloc(sizeof *w->order * INGEST__BATCH_KEYS);
+  w->bucket = malloc(sizeof *w->bucket * (nbshard + 1));
+  w->nbshard = nbshard;
+  w->a = arena_empty();
+  if (w->b != NULL) {
+    w->b->text_size = INGEST__BATCH_TEXT;
+    w->b->text = malloc(INGEST__BATCH_TEXT);
+  }
+  if (w->b == NULL || w->b->text == NULL || w->order == NULL
+      || w->bucket == NULL || w->a == NULL) {
+    return -1;
+  }
+  for (size_t k = 0; k < INGEST__PREFETCH_GROUP; k++) {
+    if ((w->l[k] = line_empty(w->a, NULL, 0, 0, nbfilemax)) == NULL) {
+      return -1;
+    }
+    w->keys[k] = &w->l[k];
+  }
+  return 0;
+}
+
+//  ingest__worker_dispose : libère les ressources de w.
+static void ingest__worker_dispose(worker *w) {
+  if (w->b != NULL) {
+    free(w->b->text);
+    free(w->b);
+  }
+  free(w->order);
+  free(w->bucket);
+  arena_dispose(&w->a);
+}
+
+//  ingest__add_group : reporte dans la partie sh de la table de src les n clés
+//    t[0], ..., t[n - 1] de w, en utilisant les ressources de w. La partie est
+//    supposée verrouillée si besoin. Renvoie 0 en cas de succès,
+//    INGEST_MALLOC_ERROR sinon.
+static int ingest__add_group(ingest *g, worker *w, const source *src,
+    shard *sh, size_t n) {
+  for (size_t k = 0; k < n; k++) {
+    line_change(w->l[k], w->t[k]->key, w->t[k]->length, w->t[k]->hashval);
+    w->hashes[k] = w->t[k]->hashval;
+  }
+  maker m = {
+    .a = shard_arena(sh), .ha = shard_holdall(sh), .r = src->r, .w = w,
+    .nbfilemax = g->fn_length
+  };
+  if (hashtable_search_add_batch(shard_hashtable(sh), w->keys, w->hashes, n,
+      src->insert ? ingest__make_line : NULL, &m, w->res) != n) {
+    return INGEST_MALLOC_ERROR;
+  }
+  for (size_t k = 0; k < n; k++) {
+    line **res = w->res[k];
+    if (res != NULL && line_nbfile(*res) >= src->nbdone
+        && (g->count
+        ? line_count(shard_arena(sh), src->i, *res)
+        : line_add(shard_arena(sh), src->i, w->t[k]->lnum, *res)) == NULL) {
+      return INGEST_MALLOC_ERROR;
+    }
+  }
+  return 0;
+}
+
+//  ingest__tokenizer_init : initialise le découpage tk des lignes de src selon
+//    les options de g.
+static void ingest__tokenizer_init(tokenizer *tk, ingest *g,
+    const source *src) {
+  tk->src = src;
+  tk->lnum = src->first;
+  tk->copy = g->upp == 1 || g->filter != NULL || !reader_mapped(src->r);
+  tk->pending = 0;
+  tk->eof = 0;
+  tk->s = NULL;
+  tk->length = 0;
+}
+
+//  ingest__batch_fill : remplit le lot b, vidé au préalable, des clés des
+//    lignes suivantes de tk, transformées et hachées, tant qu'il reste de la
+//    place, et met à jour counters. Renvoie 0 en cas de succès,
+//    INGEST_MALLOC_ERROR ou INGEST_FILE_ERROR sinon.
+static int ingest__batch_fill(ingest *g, tokenizer *tk, batch *b,
+    stage *counters) {
+  b->count = 0;
+  b->lines = 0;
+  b->bytes = 0;
+  b->text_length = 0;
+  while (b->count < INGEST__BATCH_KEYS) {
+    if (!tk->pending) {
+      int rr = reader_next(tk->src->r, &tk->s, &tk->length);
+      if (rr <= 0) {
+        tk->eof = 1;
+        return rr < 0 ? INGEST_FILE_ERROR : 0;
+      }
+      tk->pending = 1;
+    }
+    token t = {
+      .key = (char *) tk->s, .length = tk->length, .hashval = 0,
+      .lnum = tk->lnum, .keep = 1
+    };
+    if (tk->copy) {
+      if (b->text_size - b->text_length <= tk->length) {
+        if (b->count != 0) {
+          return 0;
+        }
+        char *tmp = realloc(b->text, tk->length + 1);
+        if (tmp == NULL) {
+          return INGEST_MALLOC_ERROR;
+        }
+        b->text = tmp;
+        b->text_size = tk->length + 1;
+      }
+      t.key = b->text + b->text_length;
+      t.keep = 0;
+      if (g->upp == 1 || g->filter != NULL) {
+        t.length = ingest__transform(g, tk->s, tk->length, t.key);
+      } else {
+        memcpy(t.key, tk->s, tk->length);
+        t.key[tk->length] = '\0';
+      }
+      b->text_length += t.length + 1;
+    }
+    if (t.length != 0) {
+      t.hashval = hash_bytes(t.key, t.length, g->seed);
+      b->tokens[b->count] = t;
+      b->count++;
+    }
+    b->lines++;
+    b->bytes += tk->length;
+    counters->lines++;
+    counters->bytes += tk->length;
+    tk->pending = 0;
+    tk->lnum++;
+  }
+  return 0;
+}
+
+//  ingest__add_batch : reporte les clés du lot b dans la table de src en
+//    utilisant les ressources de w. Les clés sont regroupées par partie de la
+//    table, dans l'ordre du lot, si bien que chaque partie n'est verrouillée
+//    qu'une fois par lot et que les recherches sont confiées à
+//    hashtable_search_add_batch par groupes d'au plus INGEST__PREFETCH_GROUP
+//    clés. Renvoie 0 en cas de succès, INGEST_MALLOC_ERROR sinon.
+static int ingest__add_batch(ingest *g, worker *w, const source *src,
+    const batch *b) {
+  size_t nbshard = shtable_nbshard(src->st);
+  memset(w->bucket, 0, sizeof *w->bucket * (nbshard + 1));
+  for (size_t k = 0; k < b->count; k++) {
+    w->bucket[shtable_index(src->st, b->tokens[k].hashval) + 1]++;
+  }
+  for (size_t s = 1; s <= nbshard; s++) {
+    w->bucket[s] += w->bucket[s - 1];
+  }
+  for (size_t k = 0; k < b->count; k++) {
+    w->order[w->bucket[shtable_index(src->st, b->tokens[k].hashval)]++] = k;
+  }
+  int rc = 0;
+  for (size_t s = 0, start = 0; s < nbshard && rc == 0; s++) {
+    size_t end = w->bucket[s];
+    if (start == end) {
+      continue;
+    }
+    shard *sh = shtable_nth(src->st, s);
+    if (g->locked) {
+      shard_lock(sh);
+    }
+    while (start < end && rc == 0) {
+      size_t n = 0;
+      while (start < end && n < INGEST__PREFETCH_GROUP) {
+        w->t[n] = &b->tokens[w->order[start]];
+        n++;
+        start++;
+      }
+      rc = ingest__add_group(g, w, src, sh, n);
+    }
+    if (g->locked) {
+      shard_unlock(sh);
+    }
+  }
+  return rc;
+}
+
+//  ingest__reader : lit les lignes de src et les reporte dans sa table en
+//    utilisant les ressources de w. Affecte à *nbline le numéro de la dernière
+//    ligne lue. Renvoie 0 en cas de succès, INGEST_MALLOC_ERROR ou
+//    INGEST_FILE_ERROR sinon.
+static int ingest__reader(ingest *g, worker *w, const source *src,
+    size_t *nbline) {
+  tokenizer tk;
+  ingest__tokenizer_init(&tk, g, src);
+  stage counters = {
+    0, 0, 0.0, 0.0
+  };
+  int rc = 0;
+  while (rc == 0 && !tk.eof) {
+    rc = ingest__batch_fill(g, &tk, w->b, &counters);
+    if (rc == 0) {
+      rc = ingest__add_batch(g, w, src, w->b);
+    }
+  }
+  *nbline = tk.lnum - 1;
+  return rc;
+}
+
+//  ingest__signal : signale à l'autre étape du pipeline de contexte p un
+//    changement de l'état des files ou de done.
+static void ingest__signal(producer *p) {
+  pthread_mutex_lock(&p->mutex);
+  atomic_fetch_add(&p->events, 1);
+  pthread_cond_signal(&p->cond);
+  pthread_mutex_unlock(&p->mutex);
+}
+
+//  ingest__wait : attend un changement signalé par l'autre étape du pipeline
+//    de contexte p, events valant e lors du dernier essai infructueux. Cède la
+//    main tant que *spins, incrémenté à chaque appel, est inférieur à
+//    INGEST__PIPELINE_SPINS ; s'endort ensuite jusqu'à ce que events diffère
+//    de e.
+static void ingest__wait(producer *p, size_t e, size_t *spins) {
+  if (*spins < INGEST__PIPELINE_SPINS) {
+    *spins += 1;
+    sched_yield();
+    return;
+  }
+  pthread_mutex_lock(&p->mutex);
+  while (atomic_load(&p->events) == e) {
+    pthread_cond_wait(&p->cond, &p->mutex);
+  }
+  pthread_mutex_unlock(&p->mutex);
+}
+
+//  ingest__batch_get : renvoie un lot de l'étape de lecture p, en attendant si
+//    besoin que l'étape d'ajout en rende un.
+static batch *ingest__batch_get(producer *p) {
+  batch *b = spsc_pop(p->empty);
+  if (b == NULL) {
+    double t = ingest__now();
+    size_t spins = 0;
+    size_t e = atomic_load(&p->events);
+    while ((b = spsc_pop(p->empty)) == NULL) {
+      ingest__wait(p, e, &spins);
+      e = atomic_load(&p->events);
+    }
+    p->counters.wait += ingest__now() - t;
+  }
+  return b;
+}
+
+//  ingest__batch_put : transmet le lot b de l'étape de lecture p à l'étape
+//    d'ajout, en attendant si besoin qu'une place se libère.
+static void ingest__batch_put(producer *p, batch *b) {
+  if (spsc_push(p->full, b) != 0) {
+    double t = ingest__now();
+    size_t spins = 0;
+    size_t e = atomic_load(&p->events);
+    while (spsc_push(p->full, b) != 0) {
+      ingest__wait(p, e, &spins);
+      e = atomic_load(&p->events);
+    }
+    p->counters.wait += ingest__now() - t;
+  }
+  ingest__signal(p);
+}
+
+//  ingest__produce : exécute l'étape de lecture de contexte p, de type
+//    producer *. Renvoie NULL.
+static void *ingest__produce(void *p) {
+  producer *pr = p;
+  double start = ingest__now();
+  tokenizer tk;
+  ingest__tokenizer_init(&tk, pr->g, pr->src);
+  int rc = 0;
+  while (rc == 0 && !tk.eof) {
+    batch *b = ingest__batch_get(pr);
+    rc = ingest__batch_fill(pr->g, &tk, b, &pr->counters);
+    ingest__batch_put(pr, b);
+  }
+  pr->error = rc;
+  pr->nbline = tk.lnum - 1;
+  pr->counters.busy += ingest__now() - start - pr->counters.wait;
+  atomic_store(&pr->done, 1);
+  ingest__signal(pr);
+  return NULL;
+}
+
+//  ingest__pipeline : comme ingest__reader, la lecture, le découpage, la
+//    transformation et le hachage des lignes étant confiés à un second fil
+//    d'exécution. Se comporte exactement comme ingest__reader si ce fil ne peut
+//    être créé.
+static int ingest__pipeline(ingest *g, worker *w, const source *src,
+    size_t *nbline) {
+  batch *batches[INGEST__PIPELINE_BATCHES];
+  size_t nbbatch = 0;
+  producer pr = {
+    .g = g, .src = src, .full = spsc_empty(INGEST__PIPELINE_BATCHES),
+    .empty = spsc_empty(INGEST__PIPELINE_BATCHES), .error = 0, .nbline = 0,
+    .counters = { 0, 0, 0.0, 0.0 }
+  };
+  atomic_init(&pr.done, 0);
+  atomic_init(&pr.events, 0);
+  pthread_mutex_init(&pr.mutex, NULL);
+  pthread_cond_init(&pr.cond, NULL);
+  int rc = 0;
+  pthread_t thread;
+  if (pr.full == NULL || pr.empty == NULL) {
+    rc = INGEST_MALLOC_ERROR;
+    goto dispose;
+  }
+  for (size_t k = 0; k < INGEST__PIPELINE_BATCHES; k++) {
+    batches[k] = malloc(sizeof(batch));
+    if (batches[k] == NULL) {
+      rc = INGEST_MALLOC_ERROR;
+      goto dispose;
+    }
+    nbbatch++;
+    batches[k]->text = malloc(INGEST__BATCH_TEXT);
+    batches[k]->text_size = INGEST__BATCH_TEXT;
+    if (batches[k]->text == NULL) {
+      rc = INGEST_MALLOC_ERROR;
+      goto dispose;
+    }
+    spsc_push(pr.empty, batches[k]);
+  }
+  if (pthread_create(&thread, NULL, ingest__produce, &pr) != 0) {
+    rc = ingest__reader(g, w, src, nbline);
+    goto dispose;
+  }
+  stage counters = {
+    0, 0, 0.0, 0.0
+  };
+  double start = ingest__now();
+  size_t spins = 0;
+  while (1) {
+    size_t e = atomic_load(&pr.events);
+    batch *b = spsc_pop(pr.full);
+    if (b == NULL) {
+      if (atomic_load(&pr.done)) {
+        b = spsc_pop(pr.full);
+        if (b == NULL) {
+          break;
+        }
+      } else {
+        double t = ingest__now();
+        ingest__wait(&pr, e, &spins);
+        counters.wait += ingest__now() - t;
+        continue;
+      }
+    }
+    spins = 0;
+    counters.lines += b->lines;
+    counters.bytes += b->bytes;
+    if (rc == 0) {
+      rc = ingest__add_batch(g, w, src, b);
+    }
+    spsc_push(pr.empty, b);
+    ingest__signal(&pr);
+  }
+  counters.busy = ingest__now() - start - counters.wait;
+  pthread_join(thread, NULL);
+  if (rc == 0) {
+    rc = pr.error;
+  }
+  *nbline = pr.nbline;
+  pthread_mutex_lock(&g->mutex);
+  stage *st[2] = {
+    &pr.counters, &counters
+  };
+  for (size_t k = 0; k < 2; k++) {
+    g->stages[k].lines += st[k]->lines;
+    g->stages[k].bytes += st[k]->bytes;
+    g->stages[k].busy += st[k]->busy;
+    g->stages[k].wait += st[k]->wait;
+  }
+  pthread_mutex_unlock(&g->mutex);
+dispose:
+  for (size_t k = 0; k < nbbatch; k++) {
+    free(batches[k]->text);
+    free(batches[k]);
+  }
+  spsc_dispose(&pr.full);
+  spsc_dispose(&pr.empty);
+  pthread_cond_destroy(&pr.cond);
+  pthread_mutex_destroy(&pr.mutex);
+  return rc;
+}
+
+//  ingest__file : lit le fichier order[j] de g et ajoute ses lignes à la table
+//    de g en utilisant les ressources de w. Renvoie 0 en cas de succès,
+//    INGEST_MALLOC_ERROR ou INGEST_FILE_ERROR sinon. Dans le cas où les
+//    fichiers sont traités un par un dans l'ordre, les lignes absentes de l'un
+//    des j fichiers déjà traités sont ignorées.
+static int ingest__file(ingest *g, worker *w, size_t j) {
+  size_t i = g->order[j].id;
+  size_t nbline = g->nblines[i];
+  source src = {
+    .st = g->st, .r = g->files[i], .i = i, .first = nbline + 1,
+    .insert = !g->prune || j == 0, .nbdone = g->ordered && g->prune ? j : 0
+  };
+  int rc = g->pipeline
+      ? ingest__pipeline(g, w, &src, &nbline)
+      : ingest__reader(g, w, &src, &nbline);
+  g->nblines[i] = nbline;
+  return rc;
+}
+
+shtable *ingest_table(size_t nbshard) {
+  return shtable_empty(ingest__lptreq, ingest__lptr_hfun, nbshard);
+}
+
+void *ingest_run(void *g) {
+  ingest *gi = g;
+  worker w;
+  int rc = 0;
+  size_t j = 0;
+  if (ingest__worker_init(&w, gi->fn_length, shtable_nbshard(gi->st))
+      != 0) {
+    rc = INGEST_MALLOC_ERROR;
+  }
+  while (rc == 0) {
+    pthread_mutex_lock(&gi->mutex);
+    if (gi->error != 0 || gi->next >= gi->end) {
+      pthread_mutex_unlock(&gi->mutex);
+      break;
+    }
+    j = gi->next;
+    gi->next++;
+    pthread_mutex_unlock(&gi->mutex);
+    rc = ingest__file(gi, &w, j);
+  }
+  if (rc != 0) {
+    pthread_mutex_lock(&gi->mutex);
+    if (gi->error == 0) {
+      gi->error = rc;
+      gi->fn_error = gi->order[j].id;
+    }
+    pthread_mutex_unlock(&gi->mutex);
+  }
+  ingest__worker_dispose(&w);
+  return NULL;
+}
+
+//  ingest__chunk_run : lit la partie c, de type ingest_chunk *. Renvoie
+//    NULL.
+static void *ingest__chunk_run(void *c) {
+  ingest_chunk *ch = c;
+  worker w;
+  if (ingest__worker_init(&w, ch->g->fn_length, 1) != 0 || ch->st == NULL) {
+    ch->error = INGEST_MALLOC_ERROR;
+  } else {
+    source src = {
+      .st = ch->st, .r = ch->r, .i = ch->g->order[0].id, .first = 1,
+      .insert = 1, .nbdone = 0
+    };
+    ch->error = ingest__reader(ch->g, &w, &src, &ch->nbline);
+  }
+  ingest__worker_dispose(&w);
+  return NULL;
+}
+
+//  ingest__merge_line : tente de reporter la ligne *ref, de type line **, dans
+//    la table du contexte mg, de type merger *. Renvoie une valeur non nulle en
+//    cas de dépassement de capacité, zéro sinon.
+static int ingest__merge_line(void *ref, void *mg) {
+  merger *m = mg;
+  line *l = *(line **) ref;
+  shard *sh = shtable_shard(m->st, line_hash(l));
+  line **res = hashtable_search(shard_hashtable(sh), ref);
+  if (res == NULL) {
+    line_shift(l, m->offset);
+    if (hashtable_add(shard_hashtable(sh), ref, ref) == NULL
+        || holdall_put(shard_holdall(sh), ref) != 0) {
+      return -1;
+    }
+    return 0;
+  }
+  return line_merge(shard_arena(sh), *res, l, m->offset) == NULL ? -1 : 0;
+}
+
+size_t ingest_chunks(ingest *g, size_t nbthread) {
+  size_t i = g->order[0].id;
+  reader **parts = malloc(sizeof(reader *) * nbthread);
+  ingest_chunk *chunks = malloc(sizeof(ingest_chunk) * nbthread);
+  pthread_t *threads = malloc(sizeof(pthread_t) * nbthread);
+  size_t n = 0;
+  if (parts != NULL && chunks != NULL && threads != NULL) {
+    n = reader_split(g->files[i], nbthread, INGEST__CHUNK_MIN, parts);
+  }
+  if (n == 0) {
+    free(parts);
+    free(chunks);
+    free(threads);
+    return 0;
+  }
+  g->chunks = chunks;
+  g->nbchunk = n;
+  for (size_t k = 0; k < n; k++) {
+    chunks[k] = (ingest_chunk) {
+      .g = g, .r = parts[k], .st = ingest_table(1),
+      .nbline = 0, .error = 0, .started = 0
+    };
+  }
+  for (size_t k = 1; k < n; k++) {
+    chunks[k].started
+      = pthread_create(&threads[k], NULL, ingest__chunk_run, &chunks[k]) == 0;
+  }
+  for (size_t k = 0; k < n; k++) {
+    if (!chunks[k].started) {
+      ingest__chunk_run(&chunks[k]);
+    }
+  }
+  for (size_t k = 0; k < n; k++) {
+    if (chunks[k].started) {
+      pthread_join(threads[k], NULL);
+    }
+  }
+  merger mg = {
+    .st = g->st, .offset = 0
+  };
+  for (size_t k = 0; k < n && g->error == 0; k++) {
+    if (chunks[k].error != 0) {
+      g->error = chunks[k].error;
+    } else if (holdall_apply_context(shard_holdall(shtable_nth(chunks[k].st,
+        0)), &mg, ingest__context_self, ingest__merge_line) != 0) {
+      g->error = INGEST_MALLOC_ERROR;
+    }
+    mg.offset += chunks[k].nbline;
+  }
+  g->nblines[i] = mg.offset;
+  g->fn_error = i;
+  g->next = 1;
+  free(parts);
+  free(threads);
+  return n;
+}
+
+void ingest_dispose_chunks(ingest *g) {
+  for (size_t k = 0; k < g->nbchunk; k++) {
+    reader_dispose(&g->chunks[k].r);
+    shtable_dispose(&g->chunks[k].st);
+  }
+  free(g->chunks);
+  g->chunks = NULL;
+  g->nbchunk = 0;
+}
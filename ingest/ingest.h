@@ -0,0 +1,111 @@
+//  ingest.h : partie interface d'un module de lecture des fichiers de lnid et
+//    d'ajout de leurs lignes à une table partagée. Les lignes sont lues,
+//    transformées et hachées par lots ; un fichier peut être lu par un
+//    pipeline de deux fils d'exécution, ou partagé en parties lues en
+//    parallèle puis fusionnées.
+
+#ifndef INGEST__H
+#define INGEST__H
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "reader.h"
+#include "shtable.h"
+
+//  Fonctionnement général :
+//  - les éléments de la table sont des pointeurs vers des pointeurs de line,
+//      hachés et comparés selon la valeur des lignes ;
+//  - les composants d'un contexte de lecture ne peuvent être modifiés
+//      pendant l'exécution de ingest_run ou de ingest_chunks.
+
+//  struct stage, stage : compteurs d'une étape du pipeline : nombres de lignes
+//    lues, vides comprises, et de leurs caractères avant transformation, ce
+//    qui est identique pour les deux étapes, temps passé à travailler et à
+//    attendre l'autre étape, en secondes.
+typedef struct {
+  size_t lines;
+  size_t bytes;
+  double busy;
+  double wait;
+} stage;
+
+//  struct fsize, fsize : taille size du fichier d'indice id dans la ligne de
+//    commande.
+typedef struct {
+  size_t size;
+  size_t id;
+} fsize;
+
+//  struct ingest_chunk, ingest_chunk : type et nom de type d'une partie d'un
+//    fichier lue par un fil d'exécution propre.
+typedef struct ingest_chunk ingest_chunk;
+
+//  struct ingest, ingest : contexte, partagé par les fils d'exécution, de la
+//    lecture des files de fn_length fichiers et de l'ajout de leurs lignes à
+//    la table st, les valeurs de hachage étant calculées avec le germe seed.
+//    Les options upp, filter et count sont celles de la ligne de commande ;
+//    si prune vaut 1, seul le fichier order[0] ajoute des lignes à la table.
+//    Les fichiers restant à traiter sont ceux d'indices [next, end[ dans
+//    order, next étant protégé par mutex. Si locked vaut 1, les parties de la
+//    table sont verrouillées avant utilisation ; si ordered vaut 1, les
+//    fichiers sont traités un par un dans l'ordre. error mémorise la première
+//    erreur rencontrée et, s'il s'agit d'une erreur de lecture, fn_error
+//    l'indice du fichier en cause. Si le premier fichier traité a été partagé
+//    en parties, chunks est le tableau de ses nbchunk parties, NULL sinon. Si
+//    pipeline vaut 1, les fichiers sont lus par un pipeline dont les
+//    compteurs des étapes de lecture et d'ajout, cumulés pour tous les
+//    fichiers et protégés par mutex, sont stages[0] et stages[1]. nblines[i]
+//    est le nombre de lignes déjà lues du fichier d'indice i, dont la
+//    numérotation reprend à la suite lors d'une lecture ultérieure.
+typedef struct {
+  shtable *st;
+  size_t seed;
+  reader **files;
+  const fsize *order;
+  size_t fn_length;
+  int upp;
+  int (*filter)(int);
+  int count;
+  int prune;
+  int locked;
+  int ordered;
+  pthread_mutex_t mutex;
+  size_t next;
+  size_t end;
+  int error;
+  size_t fn_error;
+  ingest_chunk *chunks;
+  size_t nbchunk;
+  int pipeline;
+  stage stages[2];
+  size_t *nblines;
+} ingest;
+
+//  Valeurs du composant error d'un contexte de lecture : dépassement de
+//    capacité, erreur de lecture.
+#define INGEST_MALLOC_ERROR 1
+#define INGEST_FILE_ERROR 2
+
+//  ingest_table : tente de créer une table partagée vide d'au moins nbshard
+//    parties, propre à recevoir les lignes lues. Renvoie NULL en cas de
+//    dépassement de capacité, un pointeur vers la table sinon.
+extern shtable *ingest_table(size_t nbshard);
+
+//  ingest_run : traite, jusqu'à épuisement ou erreur, les fichiers restants
+//    de g, de type ingest *. Renvoie NULL. Peut être exécutée par plusieurs
+//    fils d'exécution à la fois si locked vaut 1 et ordered vaut 0.
+extern void *ingest_run(void *g);
+
+//  ingest_chunks : tente de partager le fichier order[0] de g en au plus
+//    nbthread parties lues en parallèle, puis de reporter dans la table de g
+//    les lignes de chacune, dans l'ordre, en décalant leurs numéros du nombre
+//    de lignes des parties qui la précèdent. Renvoie zéro si le fichier n'a
+//    pas été partagé ; renvoie sinon le nombre de parties, le fichier étant
+//    alors traité, et l'éventuelle erreur mémorisée dans g.
+extern size_t ingest_chunks(ingest *g, size_t nbthread);
+
+//  ingest_dispose_chunks : libère les parties de g. Les lignes de la table de
+//    g ne doivent plus être utilisées ensuite.
+extern void ingest_dispose_chunks(ingest *g);
+
+#endif
@@ -1,42 +1,75 @@
 #include "line.h"
+#include <limits.h>
 #include <stdio.h>
+#include <string.h>
 
-// numéros de ligne
-typedef struct ncell ncell;
-struct ncell {
-  size_t numline;
-  ncell *next;
+// numéros de ligne : les numéros d'un fichier étant croissants, seul le
+// premier est mémorisé tel quel ; chacun des suivants l'est par sa différence
+// avec le précédent, codée sur un nombre variable d'octets (7 bits par octet,
+// le bit de poids fort indiquant si un octet suit). Les codes sont rangés dans
+// une liste de blocs de tailles croissantes ; un code n'est jamais coupé entre
+// deux blocs.
+typedef struct nblock nblock;
+struct nblock {
+  nblock *next;
+  unsigned int size;
+  unsigned int used;
+  unsigned char data[];
 };
-// cellule de fichier dans laquelle se trouve les numéros des lignes qui
-// correspondent à la valeur de la ligne
+
+#define NBLOCK_MIN 16
+#define NBLOCK_MAX 4096
+#define VARINT_MAX ((sizeof(size_t) * 8 + 6) / 7)
+
+// numéros d'un fichier : first et last sont le premier et le dernier numéro
+// ajoutés, les différences suivant le premier étant codées dans les blocs
+// de la liste repérée par head
+typedef struct nums nums;
+struct nums {
+  size_t first;
+  size_t last;
+  nblock *head;
+  nblock *tail;
+};
+
+// cellule de fichier dans laquelle se trouve le nombre d'occurrences de la
+// ligne et, si ceux-ci sont conservés, les numéros des lignes qui
+// correspondent à la valeur de la ligne. Le fichier est désigné par son
+// identifiant fileid. nums vaut NULL tant qu'aucun numéro n'a été conservé
 typedef struct fcell fcell;
 struct fcell {
-  char *fname;
+  size_t fileid;
   size_t occ;
-  ncell *head;
-  ncell *tail;
+  nums *nums;
   fcell *next;
 };
 
+// les cellules de fichier de la liste repérée par head sont rangées par
+// identifiants croissants ; last repère la dernière cellule à laquelle un
+// numéro a été ajouté, les fichiers étant en général lus l'un après l'autre
 typedef struct line {
-  char *value;
+  const char *value;
+  size_t length;
+  size_t hashval;
   size_t nbfile;
   size_t nbfilemax;
   fcell *head;
-  int (*comp)(const void *, const void *);
+  fcell *last;
 } line;
 
-line *line_empty(char *lstr, int (*comp)(const void *,
-    const void *), size_t nbfilemax) {
-  line *l = malloc(sizeof *l);
+line *line_empty(arena *a, const char *lstr, size_t length,
+    size_t hashval, size_t nbfilemax) {
+  line *l = arena_alloc(a, sizeof *l);
   if (l == NULL) {
     return NULL;
   }
   l->value = lstr;
+  l->length = length;
+  l->hashval = hashval;
   l->nbfile = 0;
   l->nbfilemax = nbfilemax;
   l->head = NULL;
-  l->comp = comp;
+  l->last = NULL;
   return l;
 }
 
@@ -54,33 +87,50 @@ size_t line_nbfilemax(line *l) {
   return l->nbfilemax;
 }
 
-char *line_value(line *l) {
+const char *line_value(line *l) {
   if (l == NULL) {
     return 0;
   }
   return l->value;
 }
 
-void *line_search(line *l, char *fname) {
+size_t line_length(line *l) {
+  if (l == NULL) {
+    return 0;
+  }
+  return l->length;
+}
+
+size_t line_hash(line *l) {
+  if (l == NULL) {
+    return 0;
+  }
+  return l->hashval;
+}
+
+void *line_search(line *l, size_t fileid) {
   if (l == NULL) {
     return NULL;
   }
+  if (l->last != NULL && l->last->fileid == fileid) {
+    return (void *) l->last;
+  }
   fcell *f = l->head;
-  while (f != NULL) {
-    if (l->comp(f->fname, fname) == 0) {
-      return (void *) f;
-    }
+  while (f != NULL && f->fileid < fileid) {
     f = f->next;
   }
-  return NULL;
+  if (f == NULL || f->fileid != fileid) {
+    return NULL;
+  }
+  return (void *) f;
 }
 
-bool line_is_in(line *l, char *fname) {
-  return line_search(l, fname) != NULL;
+bool line_is_in(line *l, size_t fileid) {
+  return line_search(l, fileid) != NULL;
 }
 
-size_t line_occfile(line *l, char *fname) {
-  fcell *f = (fcell *) line_search(l, fname);
+size_t line_occfile(line *l, size_t fileid) {
+  fcell *f = (fcell *) line_search(l, fileid);
   if (f == NULL) {
     return 0;
   }
@@ -94,94 +144,340 @@ size_t line_head_occfile(line *l) {
   return l->head->occ;
 }
 
-void line_map_occfile(void (*fun)(size_t), line *l) {
+void line_map_occfile(void (*fun)(void *context, size_t),
+    void *context, line *l) {
   if (l == NULL) {
     return;
   }
   fcell *f = l->head;
   while (f != NULL) {
-    fun(f->occ);
+    fun(context, f->occ);
     f = f->next;
   }
 }
 
-void line_map_head_num(void (*fun)(size_t), line *l) {
+void line_map_head_num(void (*fun)(void *context, size_t),
+    void *context, line *l) {
   if (l == NULL) {
     return;
   }
   if (l->head == NULL) {
     return;
   }
-  ncell *n = (l->head)->head;
-  while (n != NULL && n->next != NULL) {
-    fun(n->numline);
-    n = n->next;
+  fcell *f = l->head;
+  if (f->occ < 2 || f->nums == NULL) {
+    return;
+  }
+  size_t n = f->nums->first;
+  size_t k = f->occ - 1;
+  fun(context, n);
+  k--;
+  for (const nblock *b = f->nums->head; b != NULL && k > 0; b = b->next) {
+    const unsigned char *p = b->data;
+    const unsigned char *end = b->data + b->used;
+    while (p < end && k > 0) {
+      size_t d = 0;
+      int shift = 0;
+      do {
+        d |= (size_t) (*p & 0x7f) << shift;
+        shift += 7;
+      } while ((*p++ & 0x80) != 0);
+      n += d;
+      fun(context, n);
+      k--;
+    }
   }
 }
 
-void line_map_head_num_tail(void (*fun)(size_t), line *l) {
-  fun(l->head->tail->numline);
+void line_map_head_num_tail(void (*fun)(void *context, size_t),
+    void *context, line *l) {
+  fun(context, l->head->nums->last);
 }
 
-// fcell_dispose : sans effet si *fptr vaut NULL. Libère sinon les ressources
-//    allouées à la gestion du fichier associé à *fptr puis affecte NULL à
-//    *fptr.
-void fcell_dispose(fcell **fptr) {
-  if ((*fptr)->head == NULL) {
-    free(*fptr);
-    *fptr = NULL;
-    return;
+// varint_encode : écrit dans code, de longueur au moins VARINT_MAX, le code de
+//    d. Renvoie sa longueur.
+static unsigned int varint_encode(unsigned char *code, size_t d) {
+  unsigned int len = 0;
+  while (d >= 0x80) {
+    code[len++] = (unsigned char) (d | 0x80);
+    d >>= 7;
   }
-  ncell *n = (*fptr)->head;
-  (*fptr)->head = n->next;
-  free(n);
-  fcell_dispose(fptr);
+  code[len++] = (unsigned char) d;
+  return len;
 }
 
-void line_dispose(line **lptr) {
-  if ((*lptr)->head == NULL) {
-    if ((*lptr)->value != NULL) {
-      free((*lptr)->value);
+// varint_decode : tente de lire un code à partir de *pp, sans atteindre end.
+//    En cas de succès, affecte la valeur lue à *dptr, avance *pp au-delà du
+//    code et renvoie zéro. Renvoie une valeur non nulle sinon.
+static int varint_decode(const unsigned char **pp, const unsigned char *end,
+    size_t *dptr) {
+  const unsigned char *p = *pp;
+  size_t d = 0;
+  unsigned int shift = 0;
+  do {
+    if (p == end || shift >= sizeof(size_t) * 8) {
+      return -1;
     }
-    free(*lptr);
-    *lptr = NULL;
-    return;
+    d |= (size_t) (*p & 0x7f) << shift;
+    shift += 7;
+  } while ((*p++ & 0x80) != 0);
+  *pp = p;
+  *dptr = d;
+  return 0;
+}
+
+// nums_push : tente d'ajouter la différence d au bout des blocs de f, en
+//    allouant si besoin un nouveau bloc dans la région associée à a. Renvoie
+//    une valeur non nulle en cas de dépassement de capacité, zéro sinon.
+static int nums_push(arena *a, nums *f, size_t d) {
+  unsigned char code[VARINT_MAX];
+  unsigned int len = varint_encode(code, d);
+  nblock *b = f->tail;
+  if (b == NULL || b->size - b->used < len) {
+    unsigned int size = (b == NULL ? NBLOCK_MIN
+        : b->size < NBLOCK_MAX ? 2 * b->size : NBLOCK_MAX);
+    nblock *nb = arena_alloc(a, sizeof *nb + size);
+    if (nb == NULL) {
+      return -1;
+    }
+    nb->next = NULL;
+    nb->size = size;
+    nb->used = 0;
+    if (b == NULL) {
+      f->head = nb;
+    } else {
+      b->next = nb;
+    }
+    f->tail = nb;
+    b = nb;
+  }
+  for (unsigned int i = 0; i < len; i++) {
+    b->data[b->used++] = code[i];
+  }
+  return 0;
+}
+
+// line_fcell : renvoie la cellule du fichier d'identifiant fileid de l, après
+//    avoir tenté de la créer dans la région associée à a si elle est absente.
+//    Renvoie NULL en cas de dépassement de capacité.
+static fcell *line_fcell(arena *a, size_t fileid, line *l) {
+  fcell *f = l->last;
+  if (f == NULL || f->fileid != fileid) {
+    fcell **fp = &l->head;
+    while (*fp != NULL && (*fp)->fileid < fileid) {
+      fp = &(*fp)->next;
+    }
+    f = *fp;
+    if (f == NULL || f->fileid != fileid) {
+      f = arena_alloc(a, sizeof *f);
+      if (f == NULL) {
+        return NULL;
+      }
+      f->fileid = fileid;
+      f->occ = 0;
+      f->nums = NULL;
+      f->next = *fp;
+      *fp = f;
+      l->nbfile += 1;
+    }
+    l->last = f;
   }
-  fcell *f = (*lptr)->head;
-  (*lptr)->head = f->next;
-  fcell_dispose(&f);
-  line_dispose(lptr);
+  return f;
 }
 
-void *line_add(char *fname, size_t numline, line *l) {
+void *line_add(arena *a, size_t fileid, size_t numline, line *l) {
   if (l == NULL) {
     return NULL;
   }
-  fcell *f = line_search(l, fname);
-  ncell *nn = malloc(sizeof *nn);
-  nn->numline = numline;
-  nn->next = NULL;
+  fcell *f = line_fcell(a, fileid, l);
   if (f == NULL) {
-    fcell *nf = malloc(sizeof *nf);
-    nf->fname = fname;
-    nf->occ = 1;
-    nf->next = l->head;
-    l->head = nf;
-    l->nbfile += 1;
-    nf->head = nn;
-    nf->tail = nn;
-  } else {
-    ncell *t = f->tail;
-    t->next = nn;
-    f->tail = nn;
-    f->occ += 1;
-  }
-  return (void *) nn;
-}
-
-void line_change(line *l, char *str) {
+    return NULL;
+  }
+  if (f->nums == NULL) {
+    nums *n = arena_alloc(a, sizeof *n);
+    if (n == NULL) {
+      return NULL;
+    }
+    n->first = numline;
+    n->head = NULL;
+    n->tail = NULL;
+    f->nums = n;
+  } else if (nums_push(a, f->nums, numline - f->nums->last) != 0) {
+    return NULL;
+  }
+  f->nums->last = numline;
+  f->occ += 1;
+  return (void *) f;
+}
+
+void *line_count(arena *a, size_t fileid, line *l) {
+  if (l == NULL) {
+    return NULL;
+  }
+  fcell *f = line_fcell(a, fileid, l);
+  if (f == NULL) {
+    return NULL;
+  }
+  f->occ += 1;
+  return (void *) f;
+}
+
+void line_shift(line *l, size_t offset) {
+  if (l == NULL) {
+    return;
+  }
+  for (fcell *f = l->head; f != NULL; f = f->next) {
+    if (f->nums != NULL) {
+      f->nums->first += offset;
+      f->nums->last += offset;
+    }
+  }
+}
+
+void *line_merge(arena *a, line *l, line *src, size_t offset) {
+  if (l == NULL || src == NULL) {
+    return NULL;
+  }
+  for (fcell *fs = src->head; fs != NULL; fs = fs->next) {
+    fcell *f = line_fcell(a, fs->fileid, l);
+    if (f == NULL) {
+      return NULL;
+    }
+    nums *ns = fs->nums;
+    if (ns != NULL) {
+      ns->first += offset;
+      ns->last += offset;
+      if (f->nums == NULL) {
+        f->nums = ns;
+      } else {
+        if (nums_push(a, f->nums, ns->first - f->nums->last) != 0) {
+          return NULL;
+        }
+        if (ns->head != NULL) {
+          f->nums->tail->next = ns->head;
+          f->nums->tail = ns->tail;
+        }
+        f->nums->last = ns->last;
+      }
+    }
+    f->occ += fs->occ;
+  }
+  return (void *) l;
+}
+
+void line_remove(line *l, size_t fileid) {
+  if (l == NULL) {
+    return;
+  }
+  fcell **fp = &l->head;
+  while (*fp != NULL && (*fp)->fileid < fileid) {
+    fp = &(*fp)->next;
+  }
+  if (*fp != NULL && (*fp)->fileid == fileid) {
+    *fp = (*fp)->next;
+    l->nbfile -= 1;
+    l->last = NULL;
+  }
+}
+
+// line_put : transmet à put le code de d.
+static void line_put(void (*put)(void *, const void *, size_t),
+    void *context, size_t d) {
+  unsigned char code[VARINT_MAX];
+  put(context, code, varint_encode(code, d));
+}
+
+void line_save(line *l, void (*put)(void *context, const void *data,
+    size_t n), void *context) {
+  line_put(put, context, l->nbfile);
+  for (const fcell *f = l->head; f != NULL; f = f->next) {
+    line_put(put, context, f->fileid);
+    line_put(put, context, f->occ);
+    if (f->nums == NULL) {
+      line_put(put, context, 0);
+      continue;
+    }
+    size_t n = 0;
+    for (const nblock *b = f->nums->head; b != NULL; b = b->next) {
+      n += b->used;
+    }
+    line_put(put, context, n + 1);
+    line_put(put, context, f->nums->first);
+    line_put(put, context, f->nums->last);
+    for (const nblock *b = f->nums->head; b != NULL; b = b->next) {
+      put(context, b->data, b->used);
+    }
+  }
+}
+
+int line_load(arena *a, line *l, const void *data, size_t n) {
+  const unsigned char *p = data;
+  const unsigned char *end = p + n;
+  size_t nbfile;
+  if (l == NULL || l->head != NULL || varint_decode(&p, end, &nbfile) != 0
+      || nbfile > l->nbfilemax) {
+    return -1;
+  }
+  fcell **fp = &l->head;
+  size_t next = 0;
+  for (size_t k = 0; k < nbfile; k++) {
+    size_t fileid;
+    size_t occ;
+    size_t len;
+    if (varint_decode(&p, end, &fileid) != 0
+        || varint_decode(&p, end, &occ) != 0
+        || varint_decode(&p, end, &len) != 0
+        || fileid < next || fileid >= l->nbfilemax) {
+      return -1;
+    }
+    next = fileid + 1;
+    fcell *f = arena_alloc(a, sizeof *f);
+    if (f == NULL) {
+      return -1;
+    }
+    f->fileid = fileid;
+    f->occ = occ;
+    f->nums = NULL;
+    f->next = NULL;
+    if (len > 0) {
+      len--;
+      nums *ns = arena_alloc(a, sizeof *ns);
+      if (ns == NULL || varint_decode(&p, end, &ns->first) != 0
+          || varint_decode(&p, end, &ns->last) != 0
+          || len > (size_t) (end - p) || len > UINT_MAX) {
+        return -1;
+      }
+      ns->head = NULL;
+      ns->tail = NULL;
+      if (len > 0) {
+        nblock *b = arena_alloc(a, sizeof *b + len);
+        if (b == NULL) {
+          return -1;
+        }
+        b->next = NULL;
+        b->size = (unsigned int) len;
+        b->used = (unsigned int) len;
+        memcpy(b->data, p, len);
+        p += len;
+        ns->head = b;
+        ns->tail = b;
+      }
+      f->nums = ns;
+    }
+    *fp = f;
+    fp = &f->next;
+  }
+  l->nbfile = nbfile;
+  l->last = NULL;
+  return p == end ? 0 : -1;
+}
+
+void line_change(line *l, const char *str, size_t length,
+    size_t hashval) {
   if (l == NULL) {
     return;
   }
   l->value = str;
+  l->length = length;
+  l->hashval = hashval;
 }
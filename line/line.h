@@ -4,11 +4,13 @@
 //  - si des opérations d'allocation dynamique sont effectuées, elles le sont
 //      pour la gestion propre de la structure de données, et en aucun cas pour
 //      réaliser des copies ou des destructions d'objets ;
-//  - les fonctions qui possèdent un paramètre de type « line * » ou « line ** »
-//      ont un comportement indéterminé lorsque ce paramètre ou sa déréférence
-//      n'est pas l'adresse d'un contrôleur préalablement renvoyée avec succès
-//      par la fonction line_empty et non révoquée depuis par la fonction
-//      line_dispose ;
+//  - les allocations sont effectuées dans une région (module arena) fournie
+//      par l'utilisateurice. Les ressources associées à une ligne sont
+//      libérées lors de la libération de cette région ;
+//  - les fonctions qui possèdent un paramètre de type « line * » ont un
+//      comportement indéterminé lorsque ce paramètre n'est pas l'adresse d'un
+//      contrôleur préalablement renvoyée avec succès par la fonction
+//      line_empty et dont la région n'a pas été libérée depuis ;
 //  - aucune fonction ne peut ajouter NULL à la structure de données ;
 //  - En cas de succès, les fonctions de type de retour « void * » renvoient
 //      une référence actuellement ou auparavant stockée par la structure de
@@ -19,19 +21,30 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include "arena.h"
 
 //- STANDARD -------------------------------------------------------------------
 
 // struct line, line :
 typedef struct line line;
 
-//  line_empty : tente d'allouer les ressources nécessaires pour gérer une ligne
-//    initialement vide. Renvoie NULL en cas d'erreur. Renvoie sinon un pointeur
-//    vers le contrôleur associé à la ligne.
-extern line *line_empty(char *lstr, int (*comp)(const void *, const void *), size_t nbfilemax);
+//  line_empty : tente d'allouer dans la région associée à a les ressources
+//    nécessaires pour gérer une ligne initialement vide, de valeur les length
+//    caractères lstr, qui ne sont pas nécessairement suivis de '\0', et de
+//    valeur de hachage hashval. Renvoie NULL en cas d'erreur. Renvoie sinon un
+//    pointeur vers le contrôleur associé à la ligne.
+extern line *line_empty(arena *a, const char *lstr, size_t length,
+    size_t hashval, size_t nbfilemax);
 
-// line_value : renvoie la chaîne de caractère associée à l.
-extern char *line_value(line *l);
+// line_value : renvoie l'adresse des line_length(l) caractères de la valeur
+//    associée à l, qui ne sont pas nécessairement suivis de '\0'.
+extern const char *line_value(line *l);
+
+// line_length : renvoie la longueur de la chaîne de caractère associée à l.
+extern size_t line_length(line *l);
+
+// line_hash : renvoie la valeur de hachage associée à l.
+extern size_t line_hash(line *l);
 
 // line_nbfile : renvoie le nombre de fichiers dans lequel se trouve la ligne l.
 extern size_t line_nbfile(line *l);
@@ -39,45 +52,89 @@ extern size_t line_nbfile(line *l);
 // line_nbfilemax : renvoie le nombre de fichiers maximum de la ligne l.
 extern size_t line_nbfilemax(line *l);
 
-// line_search : recherche dans la ligne associée à l le nom d'un fichier égal à
-//    celui de fname au sens de la fonction de comparaison. Si la recherche est
-//    négative, renvoie NULL. Renvoie sinon le fichier trouvé.
-extern void *line_search(line *l, char *fname);
+//  Les fichiers sont désignés par des identifiants entiers, en pratique leur
+//    indice dans la ligne de commande. Les fichiers de la ligne sont parcourus
+//    par identifiants croissants. L'accès au dernier fichier auquel un numéro
+//    a été ajouté se fait en temps constant.
+
+// line_search : recherche dans la ligne associée à l le fichier d'identifiant
+//    fileid. Si la recherche est négative, renvoie NULL. Renvoie sinon le
+//    fichier trouvé.
+extern void *line_search(line *l, size_t fileid);
 
 // line_is_in : renvoie true ou false selon que la ligne est déjà présente dans
-//    le fichier fname ou non.
-extern bool line_is_in(line *l, char *fname);
+//    le fichier d'identifiant fileid ou non.
+extern bool line_is_in(line *l, size_t fileid);
 
 // line_occfile : renvoie le nombre d'occurence de la ligne l dans le fichier
-//    fname.
-extern size_t line_occfile(line *l, char *fname);
+//    d'identifiant fileid.
+extern size_t line_occfile(line *l, size_t fileid);
 
 // line_occfile : renvoie le nombre d'occurence de la ligne l dans le fichier
 //    de tête.
 extern size_t line_head_occfile(line *l);
 
-// line_map_occfile : applique la fonction fun à chaque occurence des fichiers
-//    de l.
-extern void line_map_occfile(void (*fun)(size_t), line *l);
+// line_map_occfile : applique la fonction fun à context et à chaque occurence
+//    des fichiers de l.
+extern void line_map_occfile(void (*fun)(void *context, size_t),
+    void *context, line *l);
 
-// line_map_head_num : applique la fonction fun à chaque numéro de ligne du
-//    fichier en tête sauf la queue.
-extern void line_map_head_num(void (*fun)(size_t), line *l);
+// line_map_head_num : applique la fonction fun à context et à chaque numéro
+//    de ligne du fichier en tête sauf la queue.
+extern void line_map_head_num(void (*fun)(void *context, size_t),
+    void *context, line *l);
 
-// line_map_head_num_tail : applique la fonction fun au numéro de la ligne
-//  en queue du fichier tête
-extern void line_map_head_num_tail(void (*fun)(size_t), line *l);
-
-// line_dispose : sans effet si *lptr vaut NULL. Libère sinon les ressources
-//    allouées à la gestion de la ligne associée à *lptr puis affecte NULL à
-//    *lptr.
-extern void line_dispose(line **lptr);
+// line_map_head_num_tail : applique la fonction fun à context et au numéro de
+//  la ligne en queue du fichier tête
+extern void line_map_head_num_tail(void (*fun)(void *context, size_t),
+    void *context, line *l);
 
 // line_add : renvoie NULL si la ligne vaut NULL. Tente sinon d'ajouter numline
-//    à la liste associée à fname. Renvoie NULL en cas de dépassement de
-//    capacité ; renvoie sinon numline
-extern void *line_add(char *fname, size_t numline, line *l);
-
-// line_change : modifie la valeur de la ligne l par la chaîne de caractères
-//    str.
-extern void line_change(line *l, char* str);
+//    à la liste associée au fichier d'identifiant fileid, les allocations
+//    éventuelles étant effectuées dans la région associée à a. Les numéros
+//    d'un même fichier doivent être ajoutés par ordre croissant. Renvoie NULL
+//    en cas de dépassement de capacité ; renvoie sinon une valeur non nulle
+extern void *line_add(arena *a, size_t fileid, size_t numline, line *l);
+
+// line_count : comme line_add, mais sans conserver de numéro : seul le nombre
+//    d'occurrences de la ligne dans le fichier d'identifiant fileid est
+//    incrémenté. Les numéros d'un fichier sont soit tous ajoutés par line_add,
+//    soit tous comptés par line_count ; dans le second cas, line_map_head_num
+//    et line_map_head_num_tail ne doivent pas être utilisées.
+extern void *line_count(arena *a, size_t fileid, line *l);
+
+// line_shift : ajoute offset à chacun des numéros de la ligne l.
+extern void line_shift(line *l, size_t offset);
+
+// line_merge : tente d'ajouter à la ligne l les occurrences de la ligne src,
+//    ses numéros étant augmentés de offset, les allocations éventuelles étant
+//    effectuées dans la région associée à a. Pour chaque fichier, les numéros
+//    ainsi augmentés doivent être supérieurs à ceux de l. Les numéros de src
+//    sont repris par l sans être recopiés : src ne doit plus être utilisée
+//    ensuite, et sa région doit être conservée aussi longtemps que l. Renvoie
+//    NULL en cas de dépassement de capacité ; renvoie sinon une valeur non
+//    nulle.
+extern void *line_merge(arena *a, line *l, line *src, size_t offset);
+
+// line_remove : retire de la ligne l les occurrences et les numéros du
+//    fichier d'identifiant fileid.
+extern void line_remove(line *l, size_t fileid);
+
+// line_save : transmet à put, accompagnés de context, par morceaux successifs
+//    de n octets, les nombres d'occurrences et les numéros de chacun des
+//    fichiers de la ligne l, sous une forme lisible par line_load.
+extern void line_save(line *l, void (*put)(void *context, const void *data,
+    size_t n), void *context);
+
+// line_load : tente d'ajouter à la ligne l, qui ne doit figurer dans aucun
+//    fichier, les occurrences et les numéros transmis par line_save sous la
+//    forme des n octets data, les allocations étant effectuées dans la région
+//    associée à a. Les octets data ne sont plus utilisés ensuite. Renvoie une
+//    valeur non nulle en cas de dépassement de capacité ou de données
+//    invalides, zéro sinon.
+extern int line_load(arena *a, line *l, const void *data, size_t n);
+
+// line_change : modifie la valeur de la ligne l par les length caractères
+//    str, de valeur de hachage hashval.
+extern void line_change(line *l, const char *str, size_t length,
+    size_t hashval);
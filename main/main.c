@@ -1,25 +1,67 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <locale.h>
+#include <time.h>
+#include <unistd.h>
+#include "arena.h"
 #include "holdall.h"
+#include "hash.h"
 #include "hashtable.h"
+#include "ingest.h"
 #include "line.h"
+#include "output.h"
+#include "psort.h"
+#include "reader.h"
+#include "report.h"
+#include "shtable.h"
+#include "snapshot.h"
 
 #define OPT_CHAR '-'
 #define OPT_FILTER_SHORT "-f"
 #define OPT_SORT_SHORT "-s"
 #define OPT_UPPERCASING_SHORT "-u"
+#define OPT_COUNT_SHORT "-c"
+#define OPT_RANGES_SHORT "-r"
+#define OPT_BINARY_SHORT "-b"
+#define OPT_INDEX_SHORT "-i"
+#define OPT_THREADS_SHORT "-j"
 #define OPT_HELP_SHORT "-h"
 #define OPT_FILTER "--filter="
 #define OPT_SORT "--sort="
 #define OPT_UPPERCASING "--uppercasing"
+#define OPT_COUNT "--count"
+#define OPT_RANGES "--ranges"
+#define OPT_BINARY "--binary"
+#define OPT_INDEX "--index="
+#define OPT_FOLLOW "--follow"
+#define OPT_FOLLOW_PERIOD "--follow="
+#define OPT_THREADS "--threads="
+#define OPT_PIPELINE "--pipeline"
+#define OPT_STATS "--stats"
 #define OPT_HELP "--help"
 
 #define DEFAULT_SIZE 10
 #define MUL 2
 
+// Longueur maximale de la description des options enregistrée dans un index
+#define OPTIONS_MAX 256
+
+// Nombre maximal de fils d'exécution et nombre de parties de la table par fil
+#define THREADS_MAX 256
+#define SHARDS_PER_THREAD 16
+
+// Taille initiale des tampons dans lesquels les lignes sont terminées par
+//  '\0' et leurs clés de collation calculées
+#define COLLATE_BUFFER 1024
+
 #define CHECK_FN_SIZE(filenames, files, fn_size, fn_length)   \
   if (fn_size == fn_length) {                                 \
     fn_size *= MUL;                                           \
@@ -28,56 +70,276 @@
       goto malloc_error;                                      \
     }                                                         \
     filenames = tmp;                                          \
-    tmp = realloc(files, sizeof(FILE *) * fn_size);           \
+    tmp = realloc(files, sizeof(reader *) * fn_size);         \
     if (tmp == NULL) {                                        \
       goto malloc_error;                                      \
     }                                                         \
     files = tmp;                                              \
   }
 
-// print_size_t_tab, print_size_t_comma: affiche un size_t
-// suivi respectivement d'une tab ou d'une virgule
-void print_size_t_tab(size_t n);
-void print_size_t_comma(size_t n);
+// print_size_t_tab, print_size_t_comma: écrit sur out, de type output *, un
+// size_t suivi respectivement d'une tab ou d'une virgule
+void print_size_t_tab(void *out, size_t n);
+void print_size_t_comma(void *out, size_t n);
 
-// lptr_hfun(a) : fonction de hachage pour les pointeurs de pointeurs
-//  de line
-size_t lptr_hfun(const void *a);
+// hseed : germe de la fonction de hachage, tiré au début de l'exécution
+size_t hseed;
 
 // close_files(files, length) : ferme tous les fichiers du tableau
-//    de fichier files de longueur length. Renvoie 0 si tout s'est bien
+//    de lecteurs files de longueur length. Renvoie 0 si tout s'est bien
 //    passé, -1 sinon.
-int close_files(FILE **files, size_t length);
-
-// lptrcmp_sd(a, b), lptrcmp_lc(a, b) comparent respectivement deux pointeurs de
-// pointeurs de line
-//  selon la fonction strcmp ou la fonction strcoll.
-int lptrcmp_sd(const void *a, const void *b);
-int lptrcmp_lc(const void *a, const void *b);
-
-// free_holdall(a) : libère les ressources associées à a puis renvoie 0
-int free_holdall(void *a);
-// free_holdall_mult(a) : affiche la line a dans le cas où il y aurait plusieurs
-// fichiers
-//  puis libère les ressources qui lui sont associé et renvoi 0
-int free_holdall_mult(void *a);
-// free_holdall_single(a) : affiche la line a dans le cas où il y aurait un seul
-// fichier
-//  puis libère les ressources qui lui sont associé et renvoi 0
-int free_holdall_single(void *a);
+int close_files(reader **files, size_t length);
+
+// lcmp(a, b) : compare les lignes a et b selon l'ordre lexicographique des
+//  octets de leurs valeurs, qui est celui de strcmp.
+int lcmp(line *a, line *b);
+
+// fsizecmp(a, b) : compare deux pointeurs de fsize selon la taille puis,
+//  à taille égale, selon l'indice décroissant.
+int fsizecmp(const void *a, const void *b);
+
+// print_stage(name, st) : affiche sur la sortie erreur les compteurs st de
+//  l'étape de nom name.
+void print_stage(const char *name, const stage *st);
+
+// context_self(context, ref) : renvoie context.
+void *context_self(void *context, void *ref);
+
+// selected_mult(l) : renvoie une valeur non nulle si la ligne l doit être
+//  affichée dans le cas où il y aurait plusieurs fichiers, c'est-à-dire si
+//  elle figure dans chacun d'eux, zéro sinon.
+int selected_mult(line *l);
+// selected_single(l) : renvoie une valeur non nulle si la ligne l doit être
+//  affichée dans le cas où il y aurait un seul fichier, c'est-à-dire si elle y
+//  figure plusieurs fois, zéro sinon.
+int selected_single(line *l);
+
+// struct gatherer, gatherer : tableau lines de lignes, de longueur count,
+//  retenues par la fonction selected.
+typedef struct {
+  line **lines;
+  size_t count;
+  int (*selected)(line *);
+} gatherer;
+
+// gather_ref(ref, gt) : ajoute la ligne *ref, de type line **, au tableau du
+//  contexte gt, de type gatherer *, si elle est retenue par gt->selected,
+//  puis renvoie zéro.
+int gather_ref(void *ref, void *gt);
+
+// struct collated, collated : ligne line accompagnée de sa clé de collation
+//  key, obtenue par strxfrm : l'ordre des clés selon strcmp est celui des
+//  lignes selon strcoll.
+typedef struct {
+  line *line;
+  char key[];
+} collated;
+
+// colcmp(a, b) : compare deux pointeurs de collated selon leurs clés, puis
+//  départage les clés égales selon lcmp, afin que l'ordre ne dépende pas de
+//  celui de l'ajout des lignes.
+int colcmp(const void *a, const void *b);
+
+// struct collator, collator : calcul des clés des n lignes lines dans cols,
+//  dans la région a. Le composant error vaut une valeur non nulle en cas de
+//  dépassement de capacité.
+typedef struct {
+  line **lines;
+  collated **cols;
+  size_t n;
+  arena *a;
+  int error;
+} collator;
+
+// collate_run(c) : calcule les clés du contexte c, de type collator *.
+//  Renvoie NULL.
+void *collate_run(void *c);
+
+// line_string(l, lenptr) : renvoie l'adresse de la valeur de la ligne l, de
+//  type line *, et affecte sa longueur à *lenptr.
+const char *line_string(void *l, size_t *lenptr);
+
+// collate(lines, n, nbthread) : trie le tableau lines de n lignes selon
+//  strcoll, en calculant une fois pour toutes la clé de collation de
+//  chaque ligne, en parallèle sur au plus nbthread fils d'exécution, puis en
+//  triant les clés. Renvoie une valeur non nulle en cas de dépassement de
+//  capacité, zéro sinon.
+int collate(line **lines, size_t n, size_t nbthread);
+
+// file_info(r, fi) : affecte à fi la taille et la date du fichier associé à
+//  r, toutes deux obtenues de ce fichier ouvert, ou une taille valant
+//  SIZE_MAX si celui-ci n'est pas un fichier régulier projeté en mémoire, la
+//  valeur de hachage de son contenu n'étant pas calculée.
+void file_info(reader *r, fileinfo *fi);
+
+// file_hash(r) : renvoie la valeur de hachage, pour le germe hseed, du contenu
+//  du fichier régulier associé à r.
+size_t file_hash(reader *r);
+
+// index_matches(snap, options, nbfile, filenames) : renvoie une valeur non
+//  nulle si l'index snap a été écrit avec la description des options options
+//  pour les nbfile fichiers de noms filenames, dans cet ordre, zéro sinon.
+int index_matches(snapshot *snap, const char *options, size_t nbfile,
+    char **filenames);
+
+// load_table(st, snap, changed, nbfilemax) : tente d'ajouter à la table st
+//  les lignes des deux sections de l'index snap, en retirant de chacune les
+//  occurrences des fichiers d'indices k tels que changed[k] vaut 1. Les
+//  valeurs des lignes restent dans la projection de snap. Renvoie une valeur
+//  non nulle en cas de dépassement de capacité ou d'index invalide, zéro
+//  sinon.
+int load_table(shtable *st, snapshot *snap, const int *changed,
+    size_t nbfilemax);
+
+// load_report(st, snap, nbfilemax) : tente d'ajouter aux lignes de la table
+//  st, sans les rechercher ni les y ranger, celles de la première section de
+//  l'index snap, c'est-à-dire celles à afficher, les sections suivantes
+//  n'étant pas lues. La table ne peut ensuite servir qu'à écrire le rapport.
+//  Renvoie une valeur non nulle en cas de dépassement de capacité ou d'index
+//  invalide, zéro sinon.
+int load_report(shtable *st, snapshot *snap, size_t nbfilemax);
+
+// struct saver, saver : contexte de save_line : les données d'une ligne,
+//  destinée à être écrite sur out, sont rassemblées dans le tampon buf de
+//  taille size, dont length octets sont utilisés. error vaut une valeur non
+//  nulle en cas de dépassement de capacité. Seules sont écrites les lignes
+//  retenues par selected si wanted vaut 1, les autres sinon.
+typedef struct {
+  output *out;
+  unsigned char *buf;
+  size_t length;
+  size_t size;
+  int error;
+  int (*selected)(line *);
+  int wanted;
+} saver;
+
+// save_put(sv, data, n) : ajoute au tampon du contexte sv, de type saver *,
+//  les n octets data.
+void save_put(void *sv, const void *data, size_t n);
+
+// save_line(ref, sv) : écrit sur la sortie du contexte sv, de type saver *, la
+//  ligne *ref, de type line **, si elle figure dans au moins un fichier et
+//  appartient à la section écrite. Renvoie une valeur non nulle en cas de
+//  dépassement de capacité, zéro sinon.
+int save_line(void *ref, void *sv);
+
+// save_table(out, rp) : écrit sur out les lignes de la table du rapport rp, de
+//  type reporter *, en deux sections : celles retenues par sa fonction
+//  selected, puis les autres. Renvoie une valeur non nulle en cas de
+//  dépassement de capacité, zéro sinon.
+int save_table(output *out, void *rp);
+
+// print_line_mult(out, l) : écrit sur out la line l dans le cas où il y aurait
+// plusieurs fichiers
+void print_line_mult(output *out, line *l);
+// print_line_single(out, l) : écrit sur out la line l dans le cas où il y
+// aurait un seul fichier
+void print_line_single(output *out, line *l);
+// print_line_count(out, l) : écrit sur out la line l dans le cas où il y
+// aurait un seul fichier et où seuls les nombres d'occurrences seraient
+// demandés
+void print_line_count(output *out, line *l);
+// print_line_ranges(out, l) : comme print_line_single, les suites de numéros
+// consécutifs étant écrites sous la forme a-b
+void print_line_ranges(output *out, line *l);
+
+// binary_line_mult(out, l), binary_line_single(out, l),
+//  binary_line_count(out, l) : écrivent sur out l'enregistrement binaire de
+//  la line l dans les mêmes cas que print_line_mult, print_line_single et
+//  print_line_count.
+void binary_line_mult(output *out, line *l);
+void binary_line_single(output *out, line *l);
+void binary_line_count(output *out, line *l);
+
+// struct delta, delta : dernier numéro prev écrit sur out.
+typedef struct {
+  output *out;
+  size_t prev;
+} delta;
+
+// binary_value(out, n) : écrit sur out, de type output *, la valeur n.
+void binary_value(void *out, size_t n);
+
+// binary_delta(d, n) : écrit sur la sortie du contexte d, de type delta *, la
+//  différence entre n et le dernier numéro écrit, puis mémorise n.
+void binary_delta(void *d, size_t n);
+
+// struct ranger, ranger : suite de numéros consécutifs en cours, de first à
+//  last, à écrire sur out. Le composant pending vaut une valeur non nulle si
+//  une suite est en cours, started si une suite a déjà été écrite.
+typedef struct {
+  output *out;
+  size_t first;
+  size_t last;
+  int pending;
+  int started;
+} ranger;
+
+// range_push(rg, n) : prolonge par n la suite en cours du contexte rg, de type
+//  ranger *, si n suit immédiatement son dernier numéro. Écrit sinon la suite
+//  en cours puis en commence une nouvelle à n.
+void range_push(void *rg, size_t n);
+
+// range_flush(rg) : écrit la suite éventuellement en cours de rg.
+void range_flush(ranger *rg);
+
+// struct reporter, reporter : paramètres du rapport écrit sur out, portant
+//  sur les nbfile fichiers de noms filenames : lignes de la table st retenues
+//  par selected, triées selon strcoll si local vaut 1, selon strcmp sinon,
+//  en utilisant au plus nbthread fils
+//  d'exécution, puis écrites selon le mode mode, au format binaire si binary
+//  vaut 1, les suites de numéros consécutifs étant regroupées si ranges
+//  vaut 1.
+typedef struct {
+  output *out;
+  shtable *st;
+  int (*selected)(line *);
+  int local;
+  size_t nbthread;
+  int mode;
+  int binary;
+  int ranges;
+  size_t nbfile;
+  char **filenames;
+} reporter;
+
+// put_header(rp) : écrit l'en-tête du rapport rp.
+void put_header(const reporter *rp);
+
+// put_report(rp) : écrit les lignes du rapport rp puis, au format binaire, sa
+//  fin. Renvoie une valeur non nulle en cas de dépassement de capacité, zéro
+//  sinon.
+int put_report(const reporter *rp);
+
+// follow_wait(sigs, period) : attend l'un des signaux de sigs, bloqués, ou,
+//  si period ne vaut pas zéro, l'écoulement de period secondes. Renvoie le
+//  numéro du signal reçu, zéro si la période s'est écoulée, -1 en cas
+//  d'erreur.
+int follow_wait(const sigset_t *sigs, size_t period);
 
 int main(int argc, char *argv[]) {
   size_t fn_size = DEFAULT_SIZE;
   size_t fn_length = 0;
   char **filenames = malloc(sizeof(char *) * fn_size);
-  FILE **files = malloc(sizeof(FILE *) * fn_size);
+  reader **files = malloc(sizeof(reader *) * fn_size);
   if (argc < 2) {
     goto syntax_error;
   }
   int fstdin = 0;
   int upp = 0;
+  int count = 0;
+  int ranges = 0;
+  int binary = 0;
+  const char *indexname = NULL;
+  int follow = 0;
+  size_t period = 0;
+  size_t nbthread = 1;
+  int pipeline = 0;
+  int stats = 0;
   setlocale(LC_ALL, "");
-  int (*lptrcmp)(const void *, const void *) = lptrcmp_sd;
+  hseed = hash_seed();
+  int local = 0;
   int (*filter)(int) = NULL;
   const char *type[12] = {
     "alpha", "alnum", "blank", "cntrl", "digit",
@@ -121,9 +383,9 @@ int main(int argc, char *argv[]) {
       i++;
       char *option = argv[i];
       if (strcmp(option, (char *) "standard") == 0) {
-        lptrcmp = lptrcmp_sd;
+        local = 0;
       } else if (strcmp(option, (char *) "local") == 0) {
-        lptrcmp = lptrcmp_lc;
+        local = 1;
       } else {
         fprintf(stderr, "Error: option sort %s unknown\n", option);
         goto syntax_error;
@@ -131,9 +393,9 @@ int main(int argc, char *argv[]) {
     } else if (strncmp(argv[i], OPT_SORT, strlen(OPT_SORT) - 1) == 0) {
       char *option = argv[i] + strlen(OPT_SORT);
       if (strcmp(option, (char *) "standard") == 0) {
-        lptrcmp = lptrcmp_sd;
+        local = 0;
       } else if (strcmp(option, (char *) "local") == 0) {
-        lptrcmp = lptrcmp_lc;
+        local = 1;
       } else {
         fprintf(stderr, "Error: option sort %s unknown\n", option);
         goto syntax_error;
@@ -141,6 +403,58 @@ int main(int argc, char *argv[]) {
     } else if (strcmp(argv[i], OPT_UPPERCASING_SHORT) == 0
         || strcmp(argv[i], OPT_UPPERCASING) == 0) {
       upp = 1;
+    } else if (strcmp(argv[i], OPT_THREADS_SHORT) == 0
+        || strncmp(argv[i], OPT_THREADS, strlen(OPT_THREADS)) == 0) {
+      char *option = argv[i] + strlen(OPT_THREADS);
+      if (strcmp(argv[i], OPT_THREADS_SHORT) == 0) {
+        if (i + 1 >= (size_t) argc) {
+          goto syntax_error;
+        }
+        i++;
+        option = argv[i];
+      }
+      char *end;
+      unsigned long n = strtoul(option, &end, 10);
+      if (*option == '\0' || *end != '\0' || n == 0 || n > THREADS_MAX) {
+        fprintf(stderr, "Error: option threads %s invalid\n", option);
+        goto syntax_error;
+      }
+      nbthread = (size_t) n;
+    } else if (strcmp(argv[i], OPT_PIPELINE) == 0) {
+      pipeline = 1;
+    } else if (strcmp(argv[i], OPT_STATS) == 0) {
+      stats = 1;
+    } else if (strcmp(argv[i], OPT_COUNT_SHORT) == 0
+        || strcmp(argv[i], OPT_COUNT) == 0) {
+      count = 1;
+    } else if (strcmp(argv[i], OPT_RANGES_SHORT) == 0
+        || strcmp(argv[i], OPT_RANGES) == 0) {
+      ranges = 1;
+    } else if (strcmp(argv[i], OPT_BINARY_SHORT) == 0
+        || strcmp(argv[i], OPT_BINARY) == 0) {
+      binary = 1;
+    } else if (strcmp(argv[i], OPT_INDEX_SHORT) == 0) {
+      if (i + 1 >= (size_t) argc) {
+        goto syntax_error;
+      }
+      i++;
+      indexname = argv[i];
+    } else if (strncmp(argv[i], OPT_INDEX, strlen(OPT_INDEX)) == 0
+        && argv[i][strlen(OPT_INDEX)] != '\0') {
+      indexname = argv[i] + strlen(OPT_INDEX);
+    } else if (strcmp(argv[i], OPT_FOLLOW) == 0) {
+      follow = 1;
+    } else if (strncmp(argv[i], OPT_FOLLOW_PERIOD,
+        strlen(OPT_FOLLOW_PERIOD)) == 0) {
+      char *option = argv[i] + strlen(OPT_FOLLOW_PERIOD);
+      char *end;
+      unsigned long n = strtoul(option, &end, 10);
+      if (*option == '\0' || *end != '\0' || n == 0) {
+        fprintf(stderr, "Error: option follow %s invalid\n", option);
+        goto syntax_error;
+      }
+      follow = 1;
+      period = (size_t) n;
     } else if (strcmp(argv[i], OPT_HELP_SHORT) == 0
         || strcmp(argv[i], OPT_HELP) == 0) {
       goto help;
@@ -148,7 +462,10 @@ int main(int argc, char *argv[]) {
       fstdin = 1;
       CHECK_FN_SIZE(filenames, files, fn_size, fn_length)
       filenames[fn_length] = (char *) "stdin";
-      files[fn_length] = stdin;
+      files[fn_length] = reader_open(NULL);
+      if (files[fn_length] == NULL) {
+        goto file_error;
+      }
       fn_length++;
     } else {
       for (size_t j = 0; j < fn_length; j++) {
@@ -159,7 +476,7 @@ int main(int argc, char *argv[]) {
       }
       CHECK_FN_SIZE(filenames, files, fn_size, fn_length)
       filenames[fn_length] = argv[i];
-      files[fn_length] = fopen(argv[i], "r");
+      files[fn_length] = reader_open(argv[i]);
       if (files[fn_length] == NULL) {
         goto file_error;
       }
@@ -169,140 +486,317 @@ int main(int argc, char *argv[]) {
   if (fn_length == 0) {
     goto syntax_error;
   }
-  for (size_t i = 0; i < fn_length; i++) {
-    printf("%s\t", filenames[i]);
-  }
-  printf("\n");
-  hashtable *ht = hashtable_empty(lptrcmp, lptr_hfun);
-  if (ht == NULL) {
-    goto malloc_error;
-  }
-  holdall *ha = holdall_empty();
-  if (ha == NULL) {
-    hashtable_dispose(&ht);
-    goto malloc_error;
-  }
-  size_t str_size = DEFAULT_SIZE;
-  size_t str_length = 0;
-  char *str = malloc(sizeof(char) * str_size);
-  if (str == NULL) {
-    hashtable_dispose(&ht);
-    holdall_dispose(&ha);
-    goto malloc_error;
-  }
-  line *l = line_empty(NULL, (int (*)(const void *,
-      const void *))strcmp, fn_length);
-  if (l == NULL) {
-    hashtable_dispose(&ht);
-    holdall_dispose(&ha);
-    free(str);
-    goto malloc_error;
-  }
-  line **lptr = &l;
-  int c;
-  size_t lnum = 1;
-  for (int i = (int) fn_length - 1; i >= 0; i--) {
-    while (1) {
-      c = fgetc(files[i]);
-      if (c == '\n' || c == EOF || c == '\0') {
-        str[str_length] = '\0';
-        if (str[0] != (char) 0) {
-          line_change(l, str);
-          line **res = hashtable_search(ht, lptr);
-          if (res == NULL) {
-            char *strtmp = malloc(sizeof(char) * str_size);
-            if (strtmp == NULL) {
-              line_dispose(lptr);
-              hashtable_dispose(&ht);
-              holdall_dispose(&ha);
-              free(filenames);
-              close_files(files, fn_length);
-              free(files);
-              goto malloc_error;
-            }
-            strcpy(strtmp, str);
-            line *t = line_empty(strtmp, (int (*)(const void *,
-                const void *))strcmp,
-                fn_length);
-            if (t == NULL) {
-              free(strtmp);
-              line_dispose(lptr);
-              hashtable_dispose(&ht);
-              holdall_dispose(&ha);
-              free(filenames);
-              close_files(files, fn_length);
-              free(files);
-              goto malloc_error;
-            }
-            line **tmp = malloc(sizeof(line *));
-            if (tmp == NULL) {
-              line_dispose(&t);
-              line_dispose(lptr);
-              hashtable_dispose(&ht);
-              holdall_dispose(&ha);
-              free(filenames);
-              close_files(files, fn_length);
-              free(files);
-              goto malloc_error;
-            }
-            *tmp = t;
-            hashtable_add(ht, tmp, tmp);
-            holdall_put(ha, tmp);
-            line_add(filenames[i], lnum, *tmp);
-          } else {
-            line_add(filenames[i], lnum, *res);
-          }
-        }
-        str_length = 0;
-        lnum++;
-        if (c == EOF) {
-          break;
-        }
-      } else {
-        if (str_length >= str_size - 1) {
-          str_size *= MUL;
-          char *tmp = realloc(str, sizeof(char) * str_size);
-          if (tmp == NULL) {
-            line_dispose(lptr);
-            hashtable_dispose(&ht);
-            holdall_dispose(&ha);
-            free(filenames);
-            close_files(files, fn_length);
-            free(files);
-            goto malloc_error;
-          }
-          str = tmp;
-        }
-        if (upp == 1) {
-          c = toupper(c);
-        }
-        if (filter != NULL) {
-          if (filter(c) != 0) {
-            str[str_length] = (char) c;
-            str_length++;
-          }
+  if (follow && indexname != NULL) {
+    fprintf(stderr, "Error: options follow and index are incompatible\n");
+    goto syntax_error;
+  }
+  if (stats && !pipeline) {
+    fprintf(stderr, "Error: option stats requires option pipeline\n");
+    goto syntax_error;
+  }
+  if (ranges && count) {
+    fprintf(stderr, "Error: options ranges and count are incompatible\n");
+    goto syntax_error;
+  }
+  if (ranges && binary) {
+    fprintf(stderr, "Error: options ranges and binary are incompatible\n");
+    goto syntax_error;
+  }
+  if (ranges && fn_length > 1) {
+    fprintf(stderr, "Error: option ranges requires a single file\n");
+    goto syntax_error;
+  }
+  // Les numéros de ligne ne sont affichés que dans le cas d'un seul fichier,
+  //  et si l'option count n'est pas donnée : sinon, seuls les nombres
+  //  d'occurrences sont conservés
+  if (fn_length > 1) {
+    count = 1;
+  }
+  // Dans le cas de plusieurs fichiers, seules les lignes présentes dans tous
+  //  les fichiers sont affichées : seul le premier fichier traité ajoute des
+  //  lignes à la table, les suivants se contentant de mettre à jour celles
+  //  qui y figurent. Avec un index, toutes les lignes sont conservées, pour
+  //  que les fichiers qui ont changé puissent être relus seuls ; de même en
+  //  mode suivi, une ligne absente d'un fichier pouvant y être ajoutée
+  ingest g = {
+    .st = NULL, .seed = 0, .files = files, .order = NULL,
+    .fn_length = fn_length,
+    .upp = upp, .filter = filter, .count = count,
+    .prune = fn_length > 1 && indexname == NULL && !follow,
+    .locked = 0, .ordered = 1, .next = 0, .end = fn_length,
+    .error = 0, .fn_error = 0, .chunks = NULL, .nbchunk = 0,
+    .pipeline = pipeline, .stages = {
+      { 0, 0, 0.0, 0.0 }, { 0, 0, 0.0, 0.0 }
+    },
+    .nblines = NULL
+  };
+  pthread_mutex_init(&g.mutex, NULL);
+  snapshot *snap = NULL;
+  fileinfo *infos = NULL;
+  int *changed = NULL;
+  char options[OPTIONS_MAX];
+  fsize *order = malloc(sizeof(fsize) * fn_length);
+  g.nblines = calloc(fn_length, sizeof(size_t));
+  g.st = ingest_table(nbthread > 1 ? SHARDS_PER_THREAD * nbthread : 1);
+  output *out = output_open(STDOUT_FILENO);
+  if (order == NULL || g.nblines == NULL || g.st == NULL || out == NULL) {
+    goto dispose_malloc_error;
+  }
+  // En mode suivi, SIGUSR1 est bloqué avant la création de tout fil
+  //  d'exécution, pour n'être reçu que par follow_wait
+  sigset_t sigs;
+  sigemptyset(&sigs);
+  if (follow) {
+    for (size_t j = 0; j < fn_length; j++) {
+      if (reader_follow(files[j]) != 0) {
+        g.fn_error = j;
+        goto dispose_file_error;
+      }
+    }
+    sigaddset(&sigs, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+  }
+  // Un index n'est repris que s'il porte sur les mêmes fichiers, lus avec les
+  //  mêmes options. Un fichier est considéré comme inchangé si sa taille et sa
+  //  date le sont, ou à défaut si la valeur de hachage de son contenu l'est ;
+  //  celle-ci est calculée avec le germe de l'index, repris pour que les
+  //  valeurs de hachage des lignes enregistrées restent valides. Si aucun
+  //  fichier n'a changé, ni en taille ni en date, seules les lignes à afficher
+  //  sont lues, depuis la première section de l'index, sans construire la
+  //  table ni vérifier l'index en entier, et l'index n'est pas réécrit. Sinon,
+  //  l'index est vérifié puis toute la table en est rechargée
+  size_t nbingest = fn_length;
+  int fresh = 0;
+  if (indexname != NULL) {
+    size_t filterid = 0;
+    for (size_t j = 0; j < 12; j++) {
+      if (filter == filter_type[j]) {
+        filterid = j + 1;
+      }
+    }
+    snprintf(options, sizeof options, "upp=%d count=%d filter=%zu ctype=%s",
+        upp, count, filterid, setlocale(LC_CTYPE, NULL));
+    infos = malloc(sizeof(fileinfo) * fn_length);
+    changed = malloc(sizeof(int) * fn_length);
+    if (infos == NULL || changed == NULL) {
+      goto dispose_malloc_error;
+    }
+    snap = snapshot_open(indexname);
+    if (snap != NULL && !index_matches(snap, options, fn_length, filenames)) {
+      snapshot_dispose(&snap);
+    }
+    if (snap != NULL) {
+      hseed = snapshot_seed(snap);
+    }
+    nbingest = 0;
+    fresh = snap != NULL;
+    for (size_t j = 0; j < fn_length; j++) {
+      const fileinfo *old = snap == NULL ? NULL : snapshot_fileinfo(snap, j);
+      file_info(files[j], &infos[j]);
+      changed[j] = 1;
+      if (infos[j].size != SIZE_MAX) {
+        if (old != NULL && old->size == infos[j].size
+            && old->mtime_sec == infos[j].mtime_sec
+            && old->mtime_nsec == infos[j].mtime_nsec) {
+          infos[j].hash = old->hash;
+          changed[j] = 0;
         } else {
-          str[str_length] = (char) c;
-          str_length++;
+          fresh = 0;
+          infos[j].hash = file_hash(files[j]);
+          changed[j] = old == NULL || old->size != infos[j].size
+              || old->hash != infos[j].hash;
         }
       }
+      nbingest += (size_t) changed[j];
+      fresh = fresh && !changed[j];
+    }
+    if (snap != NULL && (fresh
+        ? load_report(g.st, snap, fn_length) != 0
+        : snapshot_verify(snap) != 0
+        || load_table(g.st, snap, changed, fn_length) != 0)) {
+      // Index illisible : tous les fichiers sont relus, les valeurs de
+      //  hachage reprises de l'index étant recalculées
+      shtable_dispose(&g.st);
+      g.st = ingest_table(nbthread > 1 ? SHARDS_PER_THREAD * nbthread : 1);
+      if (g.st == NULL) {
+        goto dispose_malloc_error;
+      }
+      for (size_t j = 0; j < fn_length; j++) {
+        if (infos[j].size != SIZE_MAX && !changed[j]) {
+          infos[j].hash = file_hash(files[j]);
+        }
+        changed[j] = 1;
+      }
+      nbingest = fn_length;
+      fresh = 0;
     }
-    lnum = 1;
   }
-  str[str_length] = '\0';
-  line_dispose(lptr);
-  holdall_sort(ha, lptrcmp);
-  if (fn_length > 1) {
-    holdall_apply(ha, free_holdall_mult);
+  reporter rp = {
+    .out = out, .st = g.st,
+    .selected = fn_length > 1 ? selected_mult : selected_single,
+    .local = local, .nbthread = nbthread,
+    .mode = fn_length > 1 ? REPORT_MULT
+        : count ? REPORT_COUNT : REPORT_NUMBERS,
+    .binary = binary, .ranges = ranges, .nbfile = fn_length,
+    .filenames = filenames
+  };
+  put_header(&rp);
+  // Les fichiers sont traités du plus petit au plus grand, ceux dont la
+  //  taille est inconnue (entrée standard, tubes...) en dernier : dans le cas
+  //  de plusieurs fichiers, la table est ainsi bornée par le plus petit
+  //  d'entre eux. Les colonnes restent dans l'ordre de la ligne de commande,
+  //  les fichiers étant désignés par leur indice
+  for (size_t j = 0, k = 0; j < fn_length; j++) {
+    if (changed == NULL || changed[j]) {
+      order[k].size = reader_size(files[j]);
+      order[k].id = j;
+      k++;
+    }
+  }
+  qsort(order, nbingest, sizeof *order, fsizecmp);
+  g.seed = hseed;
+  g.order = order;
+  g.end = nbingest;
+  // Le premier fichier est traité seul, si possible partagé en parties lues
+  //  en parallèle ; les suivants, qui ne font que des mises à jour, sont
+  //  répartis entre les fils d'exécution
+  if (nbthread > 1 && nbingest > 0) {
+    g.end = 1;
+    if (ingest_chunks(&g, nbthread) == 0) {
+      ingest_run(&g);
+    }
+    g.end = nbingest;
+    g.locked = 1;
+    g.ordered = 0;
+    size_t nbrest = nbingest - 1;
+    size_t nbcreated = 0;
+    pthread_t *threads = malloc(sizeof(pthread_t) * nbthread);
+    if (threads != NULL) {
+      while (nbcreated + 1 < nbthread && nbcreated + 1 < nbrest
+          && pthread_create(&threads[nbcreated], NULL, ingest_run, &g) == 0) {
+        nbcreated++;
+      }
+    }
+    ingest_run(&g);
+    for (size_t k = 0; k < nbcreated; k++) {
+      pthread_join(threads[k], NULL);
+    }
+    free(threads);
   } else {
-    holdall_apply(ha, free_holdall_single);
+    ingest_run(&g);
+  }
+  if (g.error == INGEST_MALLOC_ERROR) {
+    goto dispose_malloc_error;
+  }
+  if (g.error == INGEST_FILE_ERROR) {
+    goto dispose_file_error;
+  }
+  if (stats) {
+    print_stage("reader", &g.stages[0]);
+    print_stage("inserter", &g.stages[1]);
+  }
+  if (put_report(&rp) != 0) {
+    goto dispose_malloc_error;
+  }
+  if (output_flush(out) != 0) {
+    goto dispose_write_error;
   }
-  holdall_dispose(&ha);
-  hashtable_dispose(&ht);
+  if (indexname != NULL && !fresh && snapshot_save(indexname, hseed, options,
+      fn_length, filenames, infos, save_table, &rp) != 0) {
+    goto dispose_index_error;
+  }
+  // En mode suivi, chaque signal SIGUSR1 et, si une période est donnée,
+  //  chaque période écoulée sans signal déclenchent la lecture des seules
+  //  lignes ajoutées depuis aux fichiers réguliers, numérotées à la suite des
+  //  précédentes, puis l'écriture d'un nouveau rapport complet. Celui-ci
+  //  n'est écrit à l'échéance d'une période que si des lignes terminées ont
+  //  été ajoutées. SIGINT et SIGTERM mettent fin au suivi
+  if (follow) {
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+  }
+  while (follow) {
+    int sig = follow_wait(&sigs, period);
+    if (sig != SIGUSR1 && sig != 0) {
+      break;
+    }
+    size_t nbresumed = 0;
+    for (size_t j = 0; j < fn_length; j++) {
+      int rr = reader_resume(files[j]);
+      if (rr < 0) {
+        g.fn_error = j;
+        goto dispose_file_error;
+      }
+      if (rr > 0) {
+        order[nbresumed].size = reader_size(files[j]);
+        order[nbresumed].id = j;
+        nbresumed++;
+      }
+    }
+    if (nbresumed == 0 && sig == 0) {
+      continue;
+    }
+    g.next = 0;
+    g.end = nbresumed;
+    ingest_run(&g);
+    if (g.error == INGEST_MALLOC_ERROR) {
+      goto dispose_malloc_error;
+    }
+    if (g.error == INGEST_FILE_ERROR) {
+      goto dispose_file_error;
+    }
+    put_header(&rp);
+    if (put_report(&rp) != 0) {
+      goto dispose_malloc_error;
+    }
+    if (output_flush(out) != 0) {
+      goto dispose_write_error;
+    }
+  }
+  if (output_dispose(&out) != 0) {
+    goto dispose_write_error;
+  }
+  shtable_dispose(&g.st);
+  snapshot_dispose(&snap);
+  free(infos);
+  free(changed);
+  ingest_dispose_chunks(&g);
+  pthread_mutex_destroy(&g.mutex);
+  free(g.nblines);
+  free(order);
   free(filenames);
   close_files(files, fn_length);
   free(files);
   return EXIT_SUCCESS;
+dispose_index_error:
+  fprintf(stderr, "index_error : something went wrong when writing %s\n",
+      indexname);
+  goto dispose;
+dispose_write_error:
+  fprintf(stderr, "write_error : something went wrong when writing\n");
+  goto dispose;
+dispose_file_error:
+  fprintf(stderr, "file_error : something went wrong when reading %s\n",
+      filenames[g.fn_error]);
+  goto dispose;
+dispose_malloc_error:
+  fprintf(stderr,
+      "malloc_error : something went wrong when allocating memory\n");
+dispose:
+  output_dispose(&out);
+  shtable_dispose(&g.st);
+  snapshot_dispose(&snap);
+  free(infos);
+  free(changed);
+  ingest_dispose_chunks(&g);
+  pthread_mutex_destroy(&g.mutex);
+  free(g.nblines);
+  free(order);
+  free(filenames);
+  close_files(files, fn_length);
+  free(files);
+  return EXIT_FAILURE;
 syntax_error:
   fprintf(stderr,
       "Syntax : %s FILENAME ... OPTION ...\n%s "
@@ -352,7 +846,39 @@ help:
       "l'éventuelle\n\t\t"
       "fonction spécifié par --filter, tout caractère lu correspondant à une "
       "lettre minuscule en le caractère\n"
-      "\t\tmajuscule associé.\n");
+      "\t\tmajuscule associé.\n"
+      "\n\t"OPT_COUNT_SHORT " / "OPT_COUNT " : \n\t\tOption n'affichant, "
+      "dans le cas où un seul fichier est fourni, que le nombre\n\t\t"
+      "d'occurrences des lignes répétées au lieu de leurs numéros.\n"
+      "\n\t"OPT_RANGES_SHORT " / "OPT_RANGES " : \n\t\tOption affichant "
+      "les suites de numéros consécutifs sous la forme a-b.\n\t\tRequiert "
+      "un seul fichier ; incompatible avec les options\n\t\t"
+      OPT_COUNT " et "OPT_BINARY ".\n"
+      "\n\t"OPT_BINARY_SHORT " / "OPT_BINARY " : \n\t\tOption écrivant "
+      "le résultat dans un format binaire compact,\n\t\tlisible par "
+      "lnid-dump.\n"
+      "\n\t"OPT_INDEX_SHORT " FILE / "OPT_INDEX "FILE : \n\t\tOption "
+      "enregistrant la table des lignes dans le fichier d'index FILE.\n\t\t"
+      "Si FILE a été écrit lors d'une exécution précédente sur les mêmes "
+      "fichiers\n\t\tavec les mêmes options, seuls les fichiers qui ont "
+      "changé depuis sont relus.\n"
+      "\n\t"OPT_FOLLOW " / "OPT_FOLLOW_PERIOD "N : \n\t\tOption "
+      "suivant les fichiers après le premier résultat : à chaque signal "
+      "SIGUSR1\n\t\tet, si N est donné, toutes les N secondes, seules les "
+      "lignes ajoutées depuis\n\t\tsont lues, numérotées à la suite, et un "
+      "nouveau résultat est affiché.\n\t\tSIGINT et SIGTERM mettent fin au "
+      "suivi.\n"
+      "\n\t"OPT_THREADS_SHORT " N / "OPT_THREADS "N : \n\t\tOption "
+      "répartissant entre N fils d'exécution la lecture du plus petit "
+      "fichier,\n\t\tlu en premier et partagé en parties s'il est assez "
+      "grand, celle des autres\n\t\tfichiers et le tri des lignes du "
+      "résultat.\n"
+      "\n\t"OPT_PIPELINE " : \n\t\tOption confiant la lecture, la "
+      "transformation et le hachage des lignes\n\t\tde chaque fichier à un "
+      "fil d'exécution distinct de celui qui les ajoute à la table.\n"
+      "\n\t"OPT_STATS " : \n\t\tOption affichant sur la sortie erreur "
+      "les compteurs de chacune des étapes\n\t\tdu pipeline. Requiert "
+      "l'option "OPT_PIPELINE ".\n");
   free(filenames);
   close_files(files, fn_length);
   free(files);
@@ -360,72 +886,498 @@ help:
 }
 
 #define DEFUN_PRINT_SIZE_T(fun, separator) \
-  void print_size_t ## fun(size_t n) {     \
-    printf("%zu%s", n, separator);         \
+  void print_size_t ## fun(void *out, size_t n) { \
+    output_size_t(out, n);                         \
+    output_char(out, separator);                   \
   }
 
-DEFUN_PRINT_SIZE_T(_tab, "\t")
-DEFUN_PRINT_SIZE_T(_comma, ",")
+DEFUN_PRINT_SIZE_T(_tab, '\t')
+DEFUN_PRINT_SIZE_T(_comma, ',')
 
-int close_files(FILE **files, size_t length) {
+int close_files(reader **files, size_t length) {
+  int r = 0;
   for (size_t i = 0; i < length; i++) {
-    if (fclose(files[i]) == EOF) {
-      return -1;
+    if (reader_dispose(&files[i]) != 0) {
+      r = -1;
     }
   }
+  return r;
+}
+
+int lcmp(line *a, line *b) {
+  size_t la = line_length(a);
+  size_t lb = line_length(b);
+  int c = memcmp(line_value(a), line_value(b), la < lb ? la : lb);
+  return c != 0 ? c : (la > lb) - (la < lb);
+}
+
+int fsizecmp(const void *a, const void *b) {
+  const fsize *fa = a;
+  const fsize *fb = b;
+  if (fa->size != fb->size) {
+    return fa->size < fb->size ? -1 : 1;
+  }
+  return fa->id < fb->id ? 1 : fa->id > fb->id ? -1 : 0;
+}
+
+void print_stage(const char *name, const stage *st) {
+  fprintf(stderr, "%s: %zu lines, %zu bytes, %.3f s busy, %.3f s waiting, "
+      "%.1f MB/s\n", name, st->lines, st->bytes, st->busy, st->wait,
+      st->busy > 0.0 ? (double) st->bytes / st->busy / 1e6 : 0.0);
+}
+
+void *context_self(void *context, void *ref) {
+  (void) ref;
+  return context;
+}
+
+int selected_mult(line *l) {
+  return line_nbfile(l) == line_nbfilemax(l);
+}
+
+int selected_single(line *l) {
+  return line_head_occfile(l) > 1;
+}
+
+int gather_ref(void *ref, void *gt) {
+  gatherer *t = gt;
+  if (t->selected(*(line **) ref)) {
+    t->lines[t->count] = *(line **) ref;
+    t->count++;
+  }
   return 0;
 }
 
-// lcmp_sd(a, b) et lcmp_lc comparent respectivement deux pointeurs de line
-// selon la fonction
-//  strcmp et strcoll
-#define DEFUN_LCMP(fun, cmp)                                    \
-  int fun(const void *a, const void *b) {                       \
-    return cmp(line_value((line *) a), line_value((line *) b)); \
+const char *line_string(void *l, size_t *lenptr) {
+  *lenptr = line_length(l);
+  return line_value(l);
+}
+
+int colcmp(const void *a, const void *b) {
+  const collated *x = *(collated **) a;
+  const collated *y = *(collated **) b;
+  int c = strcmp(x->key, y->key);
+  return c != 0 ? c : lcmp(x->line, y->line);
+}
+
+void *collate_run(void *c) {
+  collator *co = c;
+  size_t size = COLLATE_BUFFER;
+  size_t ssize = COLLATE_BUFFER;
+  char *buf = malloc(size);
+  char *s = malloc(ssize);
+  if (buf == NULL || s == NULL) {
+    co->error = 1;
+    goto dispose;
   }
-DEFUN_LCMP(lcmp_sd, strcmp)
-DEFUN_LCMP(lcmp_lc, strcoll)
+  for (size_t k = 0; k < co->n; k++) {
+    // strxfrm ne s'applique qu'à une chaîne : la valeur de la ligne, qui ne
+    //  contient pas '\0', est recopiée puis terminée
+    size_t len = line_length(co->lines[k]);
+    if (len >= ssize) {
+      free(s);
+      ssize = len + 1;
+      s = malloc(ssize);
+      if (s == NULL) {
+        co->error = 1;
+        goto dispose;
+      }
+    }
+    memcpy(s, line_value(co->lines[k]), len);
+    s[len] = '\0';
+    size_t n;
+    while ((n = strxfrm(buf, s, size)) >= size) {
+      free(buf);
+      size = n + 1;
+      buf = malloc(size);
+      if (buf == NULL) {
+        co->error = 1;
+        goto dispose;
+      }
+    }
+    collated *t = arena_alloc(co->a, sizeof *t + n + 1);
+    if (t == NULL) {
+      co->error = 1;
+      break;
+    }
+    t->line = co->lines[k];
+    memcpy(t->key, buf, n + 1);
+    co->cols[k] = t;
+  }
+dispose:
+  free(buf);
+  free(s);
+  return NULL;
+}
 
-#define DEFUN_LCMP_PTR(fun, lcmp)             \
-  int fun(const void *a, const void *b) {     \
-    return lcmp(*(line **) a, *(line **) b);  \
+int collate(line **lines, size_t n, size_t nbthread) {
+  if (nbthread > n) {
+    nbthread = n == 0 ? 1 : n;
+  }
+  int r = -1;
+  collated **cols = malloc(sizeof(collated *) * (n == 0 ? 1 : n));
+  collator *cos = malloc(sizeof(collator) * nbthread);
+  pthread_t *threads = malloc(sizeof(pthread_t) * nbthread);
+  size_t nbinit = 0;
+  size_t nbcreated = 0;
+  if (cols == NULL || cos == NULL || threads == NULL) {
+    goto dispose;
+  }
+  for (; nbinit < nbthread; nbinit++) {
+    size_t lo = n / nbthread * nbinit;
+    size_t hi = nbinit + 1 == nbthread ? n : n / nbthread * (nbinit + 1);
+    cos[nbinit] = (collator) {
+      .lines = lines + lo, .cols = cols + lo, .n = hi - lo,
+      .a = arena_empty(), .error = 0
+    };
+    if (cos[nbinit].a == NULL) {
+      goto dispose;
+    }
   }
+  while (nbcreated + 1 < nbthread
+      && pthread_create(&threads[nbcreated + 1], NULL, collate_run,
+      &cos[nbcreated + 1]) == 0) {
+    nbcreated++;
+  }
+  for (size_t k = nbcreated + 1; k < nbthread; k++) {
+    collate_run(&cos[k]);
+  }
+  collate_run(&cos[0]);
+  for (size_t k = 1; k <= nbcreated; k++) {
+    pthread_join(threads[k], NULL);
+  }
+  for (size_t k = 0; k < nbthread; k++) {
+    if (cos[k].error) {
+      goto dispose;
+    }
+  }
+  if (psort((void **) cols, n, colcmp, nbthread) != 0) {
+    goto dispose;
+  }
+  for (size_t k = 0; k < n; k++) {
+    lines[k] = cols[k]->line;
+  }
+  r = 0;
+dispose:
+  for (size_t k = 0; k < nbinit; k++) {
+    arena_dispose(&cos[k].a);
+  }
+  free(cols);
+  free(cos);
+  free(threads);
+  return r;
+}
 
-DEFUN_LCMP_PTR(lptrcmp_sd, lcmp_sd)
-DEFUN_LCMP_PTR(lptrcmp_lc, lcmp_lc)
+void file_info(reader *r, fileinfo *fi) {
+  fi->size = SIZE_MAX;
+  fi->mtime_sec = 0;
+  fi->mtime_nsec = 0;
+  fi->hash = 0;
+  if (reader_size(r) == SIZE_MAX
+      || reader_mtime(r, &fi->mtime_sec, &fi->mtime_nsec) != 0) {
+    fi->mtime_sec = 0;
+    fi->mtime_nsec = 0;
+    return;
+  }
+  fi->size = reader_size(r);
+}
 
-// str_hashfun(s) : fonction de hashage pour les chaines de caractères
-size_t str_hashfun(const char *s) {
-  size_t h = 0;
-  for (const unsigned char *p = (const unsigned char *) s; *p != '\0'; p++) {
-    h = 37 * h + *p;
+size_t file_hash(reader *r) {
+  size_t len;
+  const char *p = reader_data(r, &len);
+  return hash_bytes(p == NULL ? "" : p, len, hseed);
+}
+
+int index_matches(snapshot *snap, const char *options, size_t nbfile,
+    char **filenames) {
+  if (strcmp(snapshot_options(snap), options) != 0
+      || snapshot_nbfile(snap) != nbfile) {
+    return 0;
+  }
+  for (size_t k = 0; k < nbfile; k++) {
+    if (strcmp(snapshot_filename(snap, k), filenames[k]) != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int load_table(shtable *st, snapshot *snap, const int *changed,
+    size_t nbfilemax) {
+  char *s;
+  size_t len;
+  size_t hashval;
+  const void *data;
+  size_t n;
+  int rc = 0;
+  for (int section = 0; section < 2 && rc == 0; section++) {
+    while ((rc = snapshot_next(snap, &s, &len, &hashval, &data, &n)) == 1) {
+      shard *sh = shtable_shard(st, hashval);
+      line *l = line_empty(shard_arena(sh), s, len, hashval, nbfilemax);
+      line **ref = arena_alloc(shard_arena(sh), sizeof *ref);
+      if (l == NULL || ref == NULL
+          || line_load(shard_arena(sh), l, data, n) != 0) {
+        return -1;
+      }
+      for (size_t k = 0; k < nbfilemax; k++) {
+        if (changed[k]) {
+          line_remove(l, k);
+        }
+      }
+      *ref = l;
+      if (hashtable_add(shard_hashtable(sh), ref, ref) == NULL
+          || holdall_put(shard_holdall(sh), ref) != 0) {
+        return -1;
+      }
+    }
+  }
+  return rc;
+}
+
+int load_report(shtable *st, snapshot *snap, size_t nbfilemax) {
+  shard *sh = shtable_nth(st, 0);
+  char *s;
+  size_t len;
+  size_t hashval;
+  const void *data;
+  size_t n;
+  int rc;
+  while ((rc = snapshot_next(snap, &s, &len, &hashval, &data, &n)) == 1) {
+    line *l = line_empty(shard_arena(sh), s, len, hashval, nbfilemax);
+    line **ref = arena_alloc(shard_arena(sh), sizeof *ref);
+    if (l == NULL || ref == NULL
+        || line_load(shard_arena(sh), l, data, n) != 0) {
+      return -1;
+    }
+    *ref = l;
+    if (holdall_put(shard_holdall(sh), ref) != 0) {
+      return -1;
+    }
   }
-  return h;
+  return rc;
 }
 
-size_t lptr_hfun(const void *a) {
-  return str_hashfun(line_value(*(line **) a));
+void save_put(void *sv, const void *data, size_t n) {
+  saver *t = sv;
+  if (t->error) {
+    return;
+  }
+  if (n > t->size - t->length) {
+    size_t size = t->size == 0 ? DEFAULT_SIZE : t->size;
+    while (size - t->length < n) {
+      if (size > SIZE_MAX / MUL) {
+        t->error = 1;
+        return;
+      }
+      size *= MUL;
+    }
+    unsigned char *b = realloc(t->buf, size);
+    if (b == NULL) {
+      t->error = 1;
+      return;
+    }
+    t->buf = b;
+    t->size = size;
+  }
+  memcpy(t->buf + t->length, data, n);
+  t->length += n;
 }
 
-int free_holdall(void *a) {
-  line_dispose((line **) a);
-  free(a);
+int save_line(void *ref, void *sv) {
+  saver *t = sv;
+  line *l = *(line **) ref;
+  if (line_nbfile(l) == 0 || (t->selected(l) != 0) != t->wanted) {
+    return 0;
+  }
+  t->length = 0;
+  line_save(l, save_put, t);
+  if (t->error) {
+    return -1;
+  }
+  snapshot_put_line(t->out, line_value(l), line_length(l), line_hash(l),
+      t->buf, t->length);
   return 0;
 }
 
-int free_holdall_mult(void *a) {
-  if (line_nbfile(*(line **) a) == line_nbfilemax(*(line **) a)) {
-    line_map_occfile(print_size_t_tab, *(line **) a);
-    printf("%s\n", line_value(*(line **) a));
+int save_table(output *out, void *rp) {
+  const reporter *p = rp;
+  saver sv = {
+    .out = out, .buf = NULL, .length = 0, .size = 0, .error = 0,
+    .selected = p->selected, .wanted = 1
+  };
+  int r = 0;
+  for (; sv.wanted >= 0 && r == 0; sv.wanted--) {
+    for (size_t k = 0; k < shtable_nbshard(p->st) && r == 0; k++) {
+      r = holdall_apply_context(shard_holdall(shtable_nth(p->st, k)), &sv,
+          context_self, save_line);
+    }
+    if (sv.wanted == 1) {
+      snapshot_put_end(out);
+    }
+  }
+  free(sv.buf);
+  return r;
+}
+
+void print_line_mult(output *out, line *l) {
+  line_map_occfile(print_size_t_tab, out, l);
+  output_mem(out, line_value(l), line_length(l));
+  output_char(out, '\n');
+}
+
+void print_line_single(output *out, line *l) {
+  line_map_head_num(print_size_t_comma, out, l);
+  line_map_head_num_tail(print_size_t_tab, out, l);
+  output_mem(out, line_value(l), line_length(l));
+  output_char(out, '\n');
+}
+
+void range_flush(ranger *rg) {
+  if (!rg->pending) {
+    return;
+  }
+  if (rg->started) {
+    output_char(rg->out, ',');
+  }
+  output_size_t(rg->out, rg->first);
+  if (rg->last != rg->first) {
+    output_char(rg->out, '-');
+    output_size_t(rg->out, rg->last);
+  }
+  rg->pending = 0;
+  rg->started = 1;
+}
+
+void range_push(void *rg, size_t n) {
+  ranger *r = rg;
+  if (r->pending && n == r->last + 1) {
+    r->last = n;
+    return;
   }
-  return free_holdall(a);
+  range_flush(r);
+  r->first = n;
+  r->last = n;
+  r->pending = 1;
+}
+
+void print_line_ranges(output *out, line *l) {
+  ranger rg = {
+    .out = out, .first = 0, .last = 0, .pending = 0, .started = 0
+  };
+  line_map_head_num(range_push, &rg, l);
+  line_map_head_num_tail(range_push, &rg, l);
+  range_flush(&rg);
+  output_char(out, '\t');
+  output_mem(out, line_value(l), line_length(l));
+  output_char(out, '\n');
+}
+
+void binary_value(void *out, size_t n) {
+  report_put_value(out, n);
+}
+
+void binary_delta(void *d, size_t n) {
+  delta *t = d;
+  report_put_value(t->out, n - t->prev);
+  t->prev = n;
 }
 
-int free_holdall_single(void *a) {
-  if (line_head_occfile(*(line **) a) > 1) {
-    line_map_head_num(print_size_t_comma, *(line **) a);
-    line_map_head_num_tail(print_size_t_tab, *(line **) a);
-    printf("%s\n", line_value(*(line **) a));
+void binary_line_mult(output *out, line *l) {
+  report_put_line(out, line_value(l), line_length(l), line_nbfilemax(l));
+  line_map_occfile(binary_value, out, l);
+}
+
+void binary_line_single(output *out, line *l) {
+  delta d = {
+    .out = out, .prev = 0
+  };
+  report_put_line(out, line_value(l), line_length(l), line_head_occfile(l));
+  line_map_head_num(binary_delta, &d, l);
+  line_map_head_num_tail(binary_delta, &d, l);
+}
+
+void binary_line_count(output *out, line *l) {
+  report_put_line(out, line_value(l), line_length(l), 1);
+  report_put_value(out, line_head_occfile(l));
+}
+
+void print_line_count(output *out, line *l) {
+  print_size_t_tab(out, line_head_occfile(l));
+  output_mem(out, line_value(l), line_length(l));
+  output_char(out, '\n');
+}
+
+void put_header(const reporter *rp) {
+  if (rp->binary) {
+    report_put_header(rp->out, rp->mode, rp->nbfile, rp->filenames);
+  } else {
+    for (size_t i = 0; i < rp->nbfile; i++) {
+      output_string(rp->out, rp->filenames[i]);
+      output_char(rp->out, '\t');
+    }
+    output_char(rp->out, '\n');
+  }
+}
+
+int put_report(const reporter *rp) {
+  // Seules les lignes à afficher sont rassemblées, depuis toutes les parties
+  //  de la table, dans un tableau trié en parallèle : les autres, le plus
+  //  souvent très majoritaires, ne sont jamais comparées
+  size_t nbline = 0;
+  for (size_t k = 0; k < shtable_nbshard(rp->st); k++) {
+    nbline += holdall_count(shard_holdall(shtable_nth(rp->st, k)));
+  }
+  gatherer gt = {
+    .lines = malloc(sizeof(line *) * (nbline == 0 ? 1 : nbline)),
+    .count = 0, .selected = rp->selected
+  };
+  if (gt.lines == NULL) {
+    return -1;
+  }
+  for (size_t k = 0; k < shtable_nbshard(rp->st); k++) {
+    holdall_apply_context(shard_holdall(shtable_nth(rp->st, k)), &gt,
+        context_self, gather_ref);
+  }
+  if (rp->local
+      ? collate(gt.lines, gt.count, rp->nbthread) != 0
+      : psort_str((void **) gt.lines, gt.count, line_string,
+      rp->nbthread) != 0) {
+    free(gt.lines);
+    return -1;
+  }
+  // Les lignes sont écrites au fil du parcours du tableau trié, sans copie
+  void (*print)(output *, line *) = rp->binary
+      ? (rp->mode == REPORT_MULT ? binary_line_mult
+      : rp->mode == REPORT_COUNT ? binary_line_count : binary_line_single)
+      : rp->mode == REPORT_MULT ? print_line_mult
+      : rp->mode == REPORT_COUNT ? print_line_count
+      : rp->ranges ? print_line_ranges : print_line_single;
+  for (size_t k = 0; k < gt.count; k++) {
+    print(rp->out, gt.lines[k]);
+  }
+  if (rp->binary) {
+    report_put_end(rp->out);
+  }
+  free(gt.lines);
+  return 0;
+}
+
+int follow_wait(const sigset_t *sigs, size_t period) {
+  struct timespec ts = {
+    .tv_sec = (time_t) period, .tv_nsec = 0
+  };
+  while (1) {
+    int sig = period == 0
+        ? sigwaitinfo(sigs, NULL)
+        : sigtimedwait(sigs, NULL, &ts);
+    if (sig > 0) {
+      return sig;
+    }
+    if (errno == EAGAIN) {
+      return 0;
+    }
+    if (errno != EINTR) {
+      return -1;
+    }
   }
-  return free_holdall(a);
 }
@@ -0,0 +1,134 @@
+//  output.c : partie implantation d'un module d'écriture de texte sur un
+//    descripteur de fichier.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include "output.h"
+
+//  Taille du tampon
+#define OUTPUT__BUFFER_SIZE (1 << 20)
+
+//  Nombre maximal de chiffres de l'écriture décimale d'un size_t
+#define OUTPUT__DIGITS_MAX 20
+
+//  struct output, output : le composant fd mémorise le descripteur. Les
+//    caractères en attente sont les used premiers du tampon buf de longueur
+//    OUTPUT__BUFFER_SIZE. Le composant error vaut une valeur non nulle si une
+//    écriture a échoué.
+struct output {
+  int fd;
+  int error;
+  size_t used;
+  char buf[OUTPUT__BUFFER_SIZE];
+};
+
+//  Les chiffres des nombres de 00 à 99, deux par deux
+static const char output__pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+output *output_open(int fd) {
+  output *o = malloc(sizeof *o);
+  if (o == NULL) {
+    return NULL;
+  }
+  o->fd = fd;
+  o->error = 0;
+  o->used = 0;
+  return o;
+}
+
+//  output__write : tente d'écrire les n caractères pointés par s. Mémorise
+//    l'échec éventuel.
+static void output__write(output *o, const char *s, size_t n) {
+  while (n > 0 && !o->error) {
+    ssize_t k = write(o->fd, s, n);
+    if (k < 0) {
+      if (errno != EINTR) {
+        o->error = 1;
+      }
+      continue;
+    }
+    s += k;
+    n -= (size_t) k;
+  }
+}
+
+int output_flush(output *o) {
+  output__write(o, o->buf, o->used);
+  o->used = 0;
+  return o->error;
+}
+
+void output_char(output *o, char c) {
+  if (o->used == OUTPUT__BUFFER_SIZE) {
+    output_flush(o);
+  }
+  o->buf[o->used] = c;
+  o->used++;
+}
+
+void output_mem(output *o, const char *s, size_t n) {
+  if (n > OUTPUT__BUFFER_SIZE - o->used) {
+    output_flush(o);
+    if (n >= OUTPUT__BUFFER_SIZE) {
+      output__write(o, s, n);
+      return;
+    }
+  }
+  memcpy(o->buf + o->used, s, n);
+  o->used += n;
+}
+
+void output_string(output *o, const char *s) {
+  output_mem(o, s, strlen(s));
+}
+
+void output_size_t(output *o, size_t n) {
+  if (OUTPUT__BUFFER_SIZE - o->used < OUTPUT__DIGITS_MAX) {
+    output_flush(o);
+  }
+  //  Les chiffres sont calculés deux par deux, de droite à gauche, dans un
+  //    tampon local puis recopiés
+  char d[OUTPUT__DIGITS_MAX];
+  char *p = d + OUTPUT__DIGITS_MAX;
+  while (n >= 100) {
+    const char *q = output__pairs + 2 * (n % 100);
+    n /= 100;
+    p -= 2;
+    p[0] = q[0];
+    p[1] = q[1];
+  }
+  if (n >= 10) {
+    p -= 2;
+    p[0] = output__pairs[2 * n];
+    p[1] = output__pairs[2 * n + 1];
+  } else {
+    p--;
+    *p = (char) ('0' + n);
+  }
+  size_t len = (size_t) (d + OUTPUT__DIGITS_MAX - p);
+  memcpy(o->buf + o->used, p, len);
+  o->used += len;
+}
+
+int output_dispose(output **optr) {
+  if (*optr == NULL) {
+    return 0;
+  }
+  int r = output_flush(*optr);
+  free(*optr);
+  *optr = NULL;
+  return r;
+}
@@ -0,0 +1,54 @@
+//  output.h : partie interface d'un module d'écriture de texte sur un
+//    descripteur de fichier. Les caractères sont accumulés dans un grand
+//    tampon privé, transmis par un seul appel à write à chaque vidage.
+
+#ifndef OUTPUT__H
+#define OUTPUT__H
+
+#include <stdlib.h>
+
+//  Fonctionnement général :
+//  - les fonctions qui possèdent un paramètre de type « output * » ou
+//      « output ** » ont un comportement indéterminé lorsque ce paramètre ou
+//      sa déréférence n'est pas l'adresse d'un contrôleur préalablement
+//      renvoyée avec succès par la fonction output_open et non révoquée depuis
+//      par la fonction output_dispose ;
+//  - une erreur d'écriture ne fait pas échouer les fonctions d'ajout : elle
+//      est mémorisée et signalée par output_flush et output_dispose, les
+//      caractères suivants étant ignorés.
+
+//  struct output, output : type et nom de type d'un contrôleur regroupant les
+//    informations nécessaires pour écrire sur un descripteur de fichier.
+typedef struct output output;
+
+//  output_open : tente d'allouer les ressources nécessaires pour écrire sur le
+//    descripteur fd, qui n'est pas fermé par output_dispose. Renvoie NULL en
+//    cas de dépassement de capacité. Renvoie sinon un pointeur vers le
+//    contrôleur associé.
+extern output *output_open(int fd);
+
+//  output_char : ajoute le caractère c.
+extern void output_char(output *o, char c);
+
+//  output_mem : ajoute les n caractères pointés par s.
+extern void output_mem(output *o, const char *s, size_t n);
+
+//  output_string : ajoute les caractères de la chaîne s.
+extern void output_string(output *o, const char *s);
+
+//  output_size_t : ajoute l'écriture décimale de n.
+extern void output_size_t(output *o, size_t n);
+
+//  output_flush : transmet les caractères en attente. Renvoie une valeur non
+//    nulle si une erreur d'écriture s'est produite depuis la création du
+//    contrôleur, zéro sinon.
+extern int output_flush(output *o);
+
+//  output_dispose : sans effet si *optr vaut NULL et renvoie zéro. Sinon,
+//    transmet les caractères en attente, libère les ressources allouées à la
+//    gestion du contrôleur associé à *optr puis affecte NULL à *optr. Renvoie
+//    une valeur non nulle si une erreur d'écriture s'est produite depuis la
+//    création du contrôleur, zéro sinon.
+extern int output_dispose(output **optr);
+
+#endif
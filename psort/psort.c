@@ -0,0 +1,441 @@
+//  psort.c : partie implantation d'un module de tri parallèle de tableaux de
+//    références.
+//
+//  Le tableau est découpé en autant de séquences que de fils d'exécution,
+//    triées en parallèle par un tri fusion, puis les séquences sont fusionnées
+//    deux à deux par tours successifs. Pour que tous les fils travaillent
+//    jusqu'au dernier tour, chaque fusion est elle-même découpée en parties
+//    de même longueur, délimitées par recherche dichotomique.
+//
+//  Le tri de chaînes est un tri par base, octet par octet en commençant par
+//    le premier, de couples formés d'une référence et de huit octets de la
+//    chaîne associée, rangés dans un entier de sorte que l'ordre des entiers
+//    soit celui des octets. Les huit octets suivants ne sont lus qu'une fois
+//    les huit premiers épuisés. Les paquets de petite taille sont triés par
+//    insertion, les chaînes n'étant comparées qu'à égalité de préfixes.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include "psort.h"
+
+//  Longueur minimale d'une séquence triée par un même fil d'exécution
+#define PSORT__RUN_MIN 4096
+
+//  Longueur en deçà de laquelle un paquet de chaînes est trié par insertion
+#define PSORT__SMALL 32
+
+//  Nombre de valeurs d'un octet et nombre d'octets d'un préfixe
+#define PSORT__RADIX 256
+#define PSORT__PREFIX 8
+
+//  struct task, task : tâche de fusion dans dst[k0, k1[ des parties
+//    correspondantes des séquences triées a de longueur na et b de longueur
+//    nb, ou de tri de la séquence a de longueur na si b vaut NULL et dst
+//    vaut NULL.
+typedef struct {
+  void **a;
+  size_t na;
+  void **b;
+  size_t nb;
+  void **dst;
+  size_t k0;
+  size_t k1;
+} task;
+
+//  struct pool, pool : les fils d'exécution d'indices k se chargent des tâches
+//    d'indices k, k + nbthread, k + 2 * nbthread... du tableau tasks de
+//    longueur nbtask. tmp est un tampon de la longueur de la plus longue
+//    séquence à trier.
+typedef struct {
+  task *tasks;
+  size_t nbtask;
+  size_t nbthread;
+  int (*compar)(const void *, const void *);
+  void **tmp;
+} pool;
+
+typedef struct {
+  pool *p;
+  size_t id;
+} member;
+
+//  psort__corank : renvoie le nombre d'éléments de a qui figurent parmi les k
+//    premiers éléments de la fusion stable de a et b.
+static size_t psort__corank(size_t k, void **a, size_t na, void **b,
+    size_t nb, int (*compar)(const void *, const void *)) {
+  size_t lo = k > nb ? k - nb : 0;
+  size_t hi = k < na ? k : na;
+  while (lo < hi) {
+    size_t i = lo + (hi - lo) / 2;
+    size_t j = k - i;
+    if (j > 0 && compar(&b[j - 1], &a[i]) >= 0) {
+      lo = i + 1;
+    } else {
+      hi = i;
+    }
+  }
+  return lo;
+}
+
+//  psort__merge : fusionne de manière stable dans dst les séquences triées a
+//    de longueur na et b de longueur nb.
+static void psort__merge(void **a, size_t na, void **b, size_t nb,
+    void **dst, int (*compar)(const void *, const void *)) {
+  size_t i = 0;
+  size_t j = 0;
+  while (i < na && j < nb) {
+    if (compar(&b[j], &a[i]) < 0) {
+      *dst++ = b[j++];
+    } else {
+      *dst++ = a[i++];
+    }
+  }
+  memcpy(dst, a + i, (na - i) * sizeof *a);
+  memcpy(dst + (na - i), b + j, (nb - j) * sizeof *b);
+}
+
+//  psort__msort : trie de manière stable la séquence a de longueur n en
+//    utilisant le tampon tmp de même longueur.
+static void psort__msort(void **a, size_t n, void **tmp,
+    int (*compar)(const void *, const void *)) {
+  if (n < 2) {
+    return;
+  }
+  size_t h = n / 2;
+  psort__msort(a, h, tmp, compar);
+  psort__msort(a + h, n - h, tmp, compar);
+  if (compar(&a[h], &a[h - 1]) >= 0) {
+    return;
+  }
+  memcpy(tmp, a, h * sizeof *a);
+  psort__merge(tmp, h, a + h, n - h, a, compar);
+}
+
+static void psort__run(pool *p, size_t id) {
+  for (size_t k = id; k < p->nbtask; k += p->nbthread) {
+    task *t = &p->tasks[k];
+    if (t->dst == NULL) {
+      psort__msort(t->a, t->na, p->tmp + (t->a - p->tasks[0].a), p->compar);
+    } else {
+      size_t i0 = psort__corank(t->k0, t->a, t->na, t->b, t->nb, p->compar);
+      size_t i1 = psort__corank(t->k1, t->a, t->na, t->b, t->nb, p->compar);
+      psort__merge(t->a + i0, i1 - i0, t->b + (t->k0 - i0),
+          (t->k1 - i1) - (t->k0 - i0), t->dst + t->k0, p->compar);
+    }
+  }
+}
+
+static void *psort__start(void *m) {
+  member *mb = m;
+  psort__run(mb->p, mb->id);
+  return NULL;
+}
+
+//  psort__exec : exécute les tâches de p, en parallèle si possible.
+static void psort__exec(pool *p, pthread_t *threads, member *members) {
+  size_t nbcreated = 0;
+  for (size_t k = 1; k < p->nbthread && k < p->nbtask; k++) {
+    members[k] = (member) {
+      .p = p, .id = k
+    };
+    if (pthread_create(&threads[k], NULL, psort__start, &members[k]) != 0) {
+      break;
+    }
+    nbcreated++;
+  }
+  psort__run(p, 0);
+  for (size_t k = nbcreated + 1; k < p->nbthread && k < p->nbtask; k++) {
+    psort__run(p, k);
+  }
+  for (size_t k = 1; k <= nbcreated; k++) {
+    pthread_join(threads[k], NULL);
+  }
+}
+
+int psort(void **base, size_t n,
+    int (*compar)(const void *, const void *), size_t nbthread) {
+  if (n < 2) {
+    return 0;
+  }
+  size_t nbrun = nbthread;
+  if (nbrun > n / PSORT__RUN_MIN) {
+    nbrun = n / PSORT__RUN_MIN;
+  }
+  if (nbrun == 0) {
+    nbrun = 1;
+  }
+  void **tmp = malloc(n * sizeof *tmp);
+  size_t *bounds = malloc((nbrun + 1) * sizeof *bounds);
+  task *tasks = malloc(nbthread * 2 * sizeof *tasks);
+  pthread_t *threads = malloc(nbthread * sizeof *threads);
+  member *members = malloc(nbthread * sizeof *members);
+  int r = -1;
+  if (tmp == NULL || bounds == NULL || tasks == NULL || threads == NULL
+      || members == NULL) {
+    goto dispose;
+  }
+  pool p = {
+    .tasks = tasks, .nbtask = nbrun, .nbthread = nbthread,
+    .compar = compar, .tmp = tmp
+  };
+  for (size_t k = 0; k <= nbrun; k++) {
+    bounds[k] = n / nbrun * k + (k < n % nbrun ? k : n % nbrun);
+  }
+  for (size_t k = 0; k < nbrun; k++) {
+    tasks[k] = (task) {
+      .a = base + bounds[k], .na = bounds[k + 1] - bounds[k], .b = NULL,
+      .nb = 0, .dst = NULL, .k0 = 0, .k1 = 0
+    };
+  }
+  psort__exec(&p, threads, members);
+  void **src = base;
+  void **dst = tmp;
+  while (nbrun > 1) {
+    size_t nbpair = nbrun / 2;
+    size_t parts = nbthread / nbpair;
+    if (parts == 0) {
+      parts = 1;
+    }
+    p.nbtask = 0;
+    for (size_t k = 0; k < nbrun; k += 2) {
+      size_t lo = bounds[k];
+      size_t mid = bounds[k + 1];
+      size_t hi = k + 2 <= nbrun ? bounds[k + 2] : mid;
+      size_t len = hi - lo;
+      size_t m = k + 1 < nbrun ? parts : 1;
+      for (size_t q = 0; q < m; q++) {
+        tasks[p.nbtask] = (task) {
+          .a = src + lo, .na = mid - lo, .b = src + mid, .nb = hi - mid,
+          .dst = dst + lo, .k0 = len / m * q, .k1 = q + 1 == m ? len
+              : len / m * (q + 1)
+        };
+        p.nbtask++;
+      }
+      bounds[k / 2] = lo;
+    }
+    bounds[(nbrun + 1) / 2] = n;
+    nbrun = (nbrun + 1) / 2;
+    psort__exec(&p, threads, members);
+    void **t = src;
+    src = dst;
+    dst = t;
+  }
+  if (src != base) {
+    memcpy(base, src, n * sizeof *base);
+  }
+  r = 0;
+dispose:
+  free(tmp);
+  free(bounds);
+  free(tasks);
+  free(threads);
+  free(members);
+  return r;
+}
+
+//  struct pair, pair : référence ref et préfixe prefix de huit octets de la
+//    chaîne associée, le premier octet étant le plus significatif. Les octets
+//    qui suivent la fin de la chaîne valent zéro.
+typedef struct {
+  uint64_t prefix;
+  void *ref;
+} pair;
+
+//  psort__prefix : renvoie le préfixe de huit octets, à partir de l'octet
+//    depth, de la chaîne associée à ref par string.
+static uint64_t psort__prefix(void *ref, size_t depth,
+    const char *(*string)(void *, size_t *)) {
+  size_t len;
+  const char *s = string(ref, &len);
+  uint64_t x = 0;
+  for (int k = 0; k < PSORT__PREFIX; k++) {
+    x <<= 8;
+    if (depth < len) {
+      x |= (unsigned char) s[depth];
+      depth++;
+    }
+  }
+  return x;
+}
+
+//  psort__paircmp : compare les couples a et b, dont les chaînes associées
+//    ont en commun leurs depth premiers octets et dont les préfixes sont ceux
+//    des chaînes à partir de l'octet depth.
+static int psort__paircmp(const pair *a, const pair *b, size_t depth,
+    const char *(*string)(void *, size_t *)) {
+  if (a->prefix != b->prefix) {
+    return a->prefix < b->prefix ? -1 : 1;
+  }
+  if ((a->prefix & 0xff) == 0) {
+    return 0;
+  }
+  //  Les deux chaînes comptent au moins depth + PSORT__PREFIX octets
+  size_t la;
+  size_t lb;
+  const char *sa = string(a->ref, &la);
+  const char *sb = string(b->ref, &lb);
+  depth += PSORT__PREFIX;
+  int c = memcmp(sa + depth, sb + depth, (la < lb ? la : lb) - depth);
+  return c != 0 ? c : (la > lb) - (la < lb);
+}
+
+//  psort__msd : trie les n couples p, dont les chaînes associées ont en commun
+//    leurs depth + byte premiers octets et dont les préfixes sont ceux des
+//    chaînes à partir de l'octet depth, en utilisant le tampon tmp de même
+//    longueur. Le plus grand paquet est traité par itération, les autres par
+//    récursivité : la profondeur de récursivité est ainsi logarithmique.
+static void psort__msd(pair *p, pair *tmp, size_t n, unsigned byte,
+    size_t depth, const char *(*string)(void *, size_t *)) {
+  while (n >= PSORT__SMALL) {
+    if (byte == PSORT__PREFIX) {
+      depth += PSORT__PREFIX;
+      byte = 0;
+      for (size_t k = 0; k < n; k++) {
+        p[k].prefix = psort__prefix(p[k].ref, depth, string);
+      }
+    }
+    unsigned shift = 8 * (PSORT__PREFIX - 1 - byte);
+    size_t count[PSORT__RADIX] = {
+      0
+    };
+    for (size_t k = 0; k < n; k++) {
+      count[(p[k].prefix >> shift) & 0xff]++;
+    }
+    size_t start[PSORT__RADIX];
+    size_t pos[PSORT__RADIX];
+    size_t sum = 0;
+    size_t big = 0;
+    for (size_t c = 0; c < PSORT__RADIX; c++) {
+      start[c] = sum;
+      pos[c] = sum;
+      sum += count[c];
+      if (count[c] > count[big]) {
+        big = c;
+      }
+    }
+    if (count[big] != n) {
+      for (size_t k = 0; k < n; k++) {
+        tmp[pos[(p[k].prefix >> shift) & 0xff]++] = p[k];
+      }
+      memcpy(p, tmp, n * sizeof *p);
+      for (size_t c = 1; c < PSORT__RADIX; c++) {
+        if (c != big && count[c] > 1) {
+          psort__msd(p + start[c], tmp + start[c], count[c], byte + 1, depth,
+              string);
+        }
+      }
+    }
+    //  Les chaînes du paquet 0 sont terminées, donc égales
+    if (big == 0) {
+      return;
+    }
+    p += start[big];
+    tmp += start[big];
+    n = count[big];
+    byte++;
+  }
+  for (size_t k = 1; k < n; k++) {
+    pair x = p[k];
+    size_t j = k;
+    while (j > 0 && psort__paircmp(&x, &p[j - 1], depth, string) < 0) {
+      p[j] = p[j - 1];
+      j--;
+    }
+    p[j] = x;
+  }
+}
+
+//  struct radix, radix : les fils d'exécution se partagent les paquets du
+//    premier octet des couples p, délimités par start et count, en prélevant
+//    tour à tour l'indice next.
+typedef struct {
+  pair *p;
+  pair *tmp;
+  size_t start[PSORT__RADIX];
+  size_t count[PSORT__RADIX];
+  const char *(*string)(void *, size_t *);
+  atomic_size_t next;
+} radix;
+
+static void *psort__radix_run(void *rx) {
+  radix *r = rx;
+  size_t c;
+  while ((c = atomic_fetch_add(&r->next, 1)) < PSORT__RADIX) {
+    if (c != 0 && r->count[c] > 1) {
+      psort__msd(r->p + r->start[c], r->tmp + r->start[c], r->count[c], 1, 0,
+          r->string);
+    }
+  }
+  return NULL;
+}
+
+int psort_str(void **base, size_t n,
+    const char *(*string)(void *ref, size_t *lenptr), size_t nbthread) {
+  if (n < 2) {
+    return 0;
+  }
+  pair *p = malloc(n * sizeof *p);
+  pair *tmp = malloc(n * sizeof *tmp);
+  radix *r = malloc(sizeof *r);
+  pthread_t *threads = malloc(nbthread * sizeof *threads);
+  int res = -1;
+  if (p == NULL || tmp == NULL || r == NULL || threads == NULL) {
+    goto dispose;
+  }
+  for (size_t k = 0; k < n; k++) {
+    p[k] = (pair) {
+      .prefix = psort__prefix(base[k], 0, string), .ref = base[k]
+    };
+  }
+  if (nbthread < 2 || n < PSORT__RUN_MIN) {
+    psort__msd(p, tmp, n, 0, 0, string);
+  } else {
+    //  Le premier octet est distribué ici, les paquets qui en résultent étant
+    //    triés en parallèle
+    r->p = p;
+    r->tmp = tmp;
+    r->string = string;
+    atomic_init(&r->next, 0);
+    size_t pos[PSORT__RADIX];
+    size_t sum = 0;
+    for (size_t c = 0; c < PSORT__RADIX; c++) {
+      r->count[c] = 0;
+    }
+    for (size_t k = 0; k < n; k++) {
+      r->count[p[k].prefix >> 56]++;
+    }
+    for (size_t c = 0; c < PSORT__RADIX; c++) {
+      r->start[c] = sum;
+      pos[c] = sum;
+      sum += r->count[c];
+    }
+    for (size_t k = 0; k < n; k++) {
+      tmp[pos[p[k].prefix >> 56]++] = p[k];
+    }
+    memcpy(p, tmp, n * sizeof *p);
+    size_t nbcreated = 0;
+    while (nbcreated + 1 < nbthread
+        && pthread_create(&threads[nbcreated], NULL, psort__radix_run, r)
+        == 0) {
+      nbcreated++;
+    }
+    psort__radix_run(r);
+    for (size_t k = 0; k < nbcreated; k++) {
+      pthread_join(threads[k], NULL);
+    }
+  }
+  for (size_t k = 0; k < n; k++) {
+    base[k] = p[k].ref;
+  }
+  res = 0;
+dispose:
+  free(p);
+  free(tmp);
+  free(r);
+  free(threads);
+  return res;
+}
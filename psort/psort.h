@@ -0,0 +1,29 @@
+//  psort.h : partie interface d'un module de tri parallèle de tableaux de
+//    références.
+
+#ifndef PSORT__H
+#define PSORT__H
+
+#include <stdlib.h>
+
+//  psort : trie par ordre croissant le tableau base de n références selon la
+//    fonction compar, appelée comme par qsort avec les adresses de deux
+//    éléments du tableau, en répartissant le travail entre au plus nbthread
+//    fils d'exécution. Le tri est stable. Renvoie une valeur non nulle en cas
+//    de dépassement de capacité, le tableau étant alors laissé dans un ordre
+//    quelconque. Renvoie sinon zéro.
+extern int psort(void **base, size_t n,
+    int (*compar)(const void *, const void *), size_t nbthread);
+
+//  psort_str : trie par ordre croissant le tableau base de n références selon
+//    l'ordre lexicographique des octets des chaînes associées, en répartissant
+//    le travail entre au plus nbthread fils d'exécution. La chaîne associée à
+//    une référence ref est formée des *lenptr caractères string(ref, lenptr),
+//    qui ne doivent pas contenir '\0' ; l'ordre est alors celui de strcmp. Les
+//    références de chaînes égales sont dans un ordre quelconque. Renvoie une
+//    valeur non nulle en cas de dépassement de capacité, le tableau étant
+//    alors laissé inchangé. Renvoie sinon zéro.
+extern int psort_str(void **base, size_t n,
+    const char *(*string)(void *ref, size_t *lenptr), size_t nbthread);
+
+#endif
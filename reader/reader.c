@@ -0,0 +1,349 @@
+//  reader.c : partie implantation d'un module de lecture de fichiers texte par
+//    lignes.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "reader.h"
+#include "scan.h"
+
+//  Taille initiale du tampon utilisé lorsque le fichier ne peut pas être
+//    projeté en mémoire. Le tampon est agrandi si une ligne ne tient pas
+//    dedans.
+
+#define READER__BLOCK_SIZE (1 << 20)
+#define READER__MUL 2
+
+//  struct reader, reader : le composant fd mémorise le descripteur du fichier.
+//    Si le fichier est projeté en mémoire, map et mapsize mémorisent l'adresse
+//    et la longueur de la projection ; map vaut NULL sinon, et buf et bufsize
+//    mémorisent l'adresse et la longueur du tampon de lecture. Les caractères
+//    non encore fournis sont ceux de l'intervalle [cur, end[ ; ceux de
+//    l'intervalle [cur, scan[ ne contiennent aucun terminateur. Le composant
+//    eof indique si la fin du fichier a été atteinte. Le composant shared
+//    vaut 1 si le contrôleur lit une partie d'un fichier projeté par un autre
+//    contrôleur, auquel appartiennent alors la projection et le descripteur.
+//    Si follow vaut 1, une dernière ligne non terminée n'est pas fournie, et
+//    map est l'adresse d'une projection du début du fichier de longueur span,
+//    dont seuls les mapsize premiers caractères sont accessibles.
+
+//  La projection est accessible en lecture seule : une ligne conservée via
+//    reader_keep est repérée par son adresse et sa longueur, sans
+//    terminateur, si bien qu'aucune page n'est recopiée et que la projection
+//    reste partagée avec le cache du système.
+
+//  Longueur maximale de l'espace d'adressage réservé à la projection d'un
+//    fichier suivi, divisée par deux tant que la réservation échoue. Les
+//    caractères ajoutés au fichier y sont rendus accessibles en place : les
+//    adresses déjà fournies restent valides, sans qu'aucune nouvelle
+//    projection soit créée.
+#define READER__FOLLOW_SPAN ((size_t) 1 << (sizeof(size_t) > 4 ? 40 : 30))
+
+struct reader {
+  int fd;
+  char *map;
+  size_t mapsize;
+  char *buf;
+  size_t bufsize;
+  const char *cur;
+  const char *scan;
+  const char *end;
+  int eof;
+  int shared;
+  int follow;
+  size_t span;
+};
+
+//  reader__map : tente de projeter en mémoire le fichier associé à r. Renvoie
+//    zéro en cas de succès, une valeur non nulle sinon.
+static int reader__map(reader *r) {
+  struct stat st;
+  if (fstat(r->fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    return -1;
+  }
+  if (st.st_size == 0) {
+    r->eof = 1;
+    return 0;
+  }
+  if ((unsigned long long) st.st_size > SIZE_MAX) {
+    return -1;
+  }
+  size_t n = (size_t) st.st_size;
+  void *p = mmap(NULL, n, PROT_READ, MAP_PRIVATE, r->fd, 0);
+  if (p == MAP_FAILED) {
+    return -1;
+  }
+  posix_madvise(p, n, POSIX_MADV_SEQUENTIAL);
+  r->map = p;
+  r->mapsize = n;
+  r->cur = r->map;
+  r->scan = r->map;
+  r->end = r->map + n;
+  r->eof = 1;
+  return 0;
+}
+
+reader *reader_open(const char *fname) {
+  int fd = STDIN_FILENO;
+  if (fname != NULL && (fd = open(fname, O_RDONLY)) < 0) {
+    return NULL;
+  }
+  reader *r = malloc(sizeof *r);
+  if (r == NULL) {
+    close(fd);
+    return NULL;
+  }
+  r->fd = fd;
+  r->map = NULL;
+  r->mapsize = 0;
+  r->buf = NULL;
+  r->bufsize = 0;
+  r->cur = NULL;
+  r->scan = NULL;
+  r->end = NULL;
+  r->eof = 0;
+  r->shared = 0;
+  r->follow = 0;
+  r->span = 0;
+  if (reader__map(r) == 0) {
+    return r;
+  }
+  r->bufsize = READER__BLOCK_SIZE;
+  r->buf = malloc(r->bufsize);
+  if (r->buf == NULL) {
+    close(fd);
+    free(r);
+    return NULL;
+  }
+  r->cur = r->buf;
+  r->scan = r->buf;
+  r->end = r->buf;
+  return r;
+}
+
+//  reader__fill : déplace en début de tampon les caractères non encore fournis
+//    puis tente de compléter le tampon par une lecture. Agrandit le tampon s'il
+//    est plein. Renvoie zéro en cas de succès, une valeur non nulle sinon.
+static int reader__fill(reader *r) {
+  size_t rest = (size_t) (r->end - r->cur);
+  size_t scanned = (size_t) (r->scan - r->cur);
+  if (r->cur != r->buf) {
+    memmove(r->buf, r->cur, rest);
+  }
+  if (rest == r->bufsize) {
+    if (r->bufsize > SIZE_MAX / READER__MUL) {
+      return -1;
+    }
+    char *t = realloc(r->buf, r->bufsize * READER__MUL);
+    if (t == NULL) {
+      return -1;
+    }
+    r->buf = t;
+    r->bufsize *= READER__MUL;
+  }
+  r->cur = r->buf;
+  r->scan = r->buf + scanned;
+  r->end = r->buf + rest;
+  ssize_t n;
+  do {
+    n = read(r->fd, r->buf + rest, r->bufsize - rest);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    return -1;
+  }
+  if (n == 0) {
+    r->eof = 1;
+  }
+  r->end += n;
+  return 0;
+}
+
+int reader_next(reader *r, const char **sptr, size_t *lenptr) {
+  while (1) {
+    const char *p = scan_eol(r->scan, r->end);
+    if (p < r->end) {
+      *sptr = r->cur;
+      *lenptr = (size_t) (p - r->cur);
+      r->cur = p + 1;
+      r->scan = r->cur;
+      return 1;
+    }
+    r->scan = p;
+    if (r->eof) {
+      if (r->cur == r->end || r->follow) {
+        return 0;
+      }
+      *sptr = r->cur;
+      *lenptr = (size_t) (r->end - r->cur);
+      r->cur = r->end;
+      r->scan = r->end;
+      return 1;
+    }
+    if (reader__fill(r) != 0) {
+      return -1;
+    }
+  }
+}
+
+const char *reader_keep(reader *r, const char *s, size_t len) {
+  (void) len;
+  return r->map == NULL ? NULL : s;
+}
+
+size_t reader_split(reader *r, size_t n, size_t minsize, reader **parts) {
+  if (r->map == NULL || r->follow || n < 2) {
+    return 0;
+  }
+  size_t chunk = (size_t) (r->end - r->cur) / n;
+  if (chunk < minsize) {
+    chunk = minsize;
+  }
+  if (chunk == 0) {
+    return 0;
+  }
+  size_t k = 0;
+  const char *start = r->cur;
+  while (start < r->end) {
+    const char *stop = r->end;
+    if (k + 1 < n && (size_t) (r->end - start) > chunk) {
+      stop = scan_eol(start + chunk - 1, r->end);
+      if (stop < r->end) {
+        stop++;
+      }
+    }
+    reader *p = malloc(sizeof *p);
+    if (p == NULL) {
+      break;
+    }
+    *p = *r;
+    p->fd = -1;
+    p->cur = start;
+    p->scan = start;
+    p->end = stop;
+    p->shared = 1;
+    p->follow = 0;
+    parts[k] = p;
+    k++;
+    start = stop;
+  }
+  if (start < r->end || k < 2) {
+    for (size_t j = 0; j < k; j++) {
+      free(parts[j]);
+    }
+    return 0;
+  }
+  r->cur = r->end;
+  r->scan = r->end;
+  return k;
+}
+
+int reader_mapped(reader *r) {
+  return r->map != NULL;
+}
+
+const char *reader_data(reader *r, size_t *lenptr) {
+  *lenptr = r->mapsize;
+  return r->map;
+}
+
+int reader_follow(reader *r) {
+  if (r->buf != NULL || r->shared || r->follow) {
+    return 0;
+  }
+  size_t span = READER__FOLLOW_SPAN;
+  void *p;
+  while ((p = mmap(NULL, span, PROT_NONE, MAP_PRIVATE, r->fd, 0))
+      == MAP_FAILED) {
+    span /= 2;
+    if (span <= r->mapsize) {
+      return -1;
+    }
+  }
+  if (r->mapsize > 0 && mprotect(p, r->mapsize, PROT_READ) != 0) {
+    munmap(p, span);
+    return -1;
+  }
+  size_t pos = 0;
+  if (r->map != NULL) {
+    pos = (size_t) (r->cur - r->map);
+    munmap(r->map, r->mapsize);
+    posix_madvise(p, r->mapsize, POSIX_MADV_SEQUENTIAL);
+  }
+  r->map = p;
+  r->cur = r->map + pos;
+  r->scan = r->cur;
+  r->end = r->map + r->mapsize;
+  r->follow = 1;
+  r->span = span;
+  return 0;
+}
+
+int reader_resume(reader *r) {
+  if (!r->follow) {
+    return 0;
+  }
+  struct stat st;
+  if (fstat(r->fd, &st) != 0 || (unsigned long long) st.st_size > SIZE_MAX
+      || (size_t) st.st_size < r->mapsize || (size_t) st.st_size > r->span) {
+    return -1;
+  }
+  size_t n = (size_t) st.st_size;
+  if (n == r->mapsize) {
+    return 0;
+  }
+  long pagesize = sysconf(_SC_PAGESIZE);
+  if (pagesize <= 0) {
+    return -1;
+  }
+  size_t start = r->mapsize - r->mapsize % (size_t) pagesize;
+  if (mprotect(r->map + start, n - start, PROT_READ) != 0) {
+    return -1;
+  }
+  r->mapsize = n;
+  r->end = r->map + n;
+  r->scan = scan_eol(r->scan, r->end);
+  return r->scan < r->end;
+}
+
+size_t reader_size(reader *r) {
+  if (r->map != NULL) {
+    return r->mapsize;
+  }
+  return r->buf == NULL ? 0 : SIZE_MAX;
+}
+
+int reader_mtime(reader *r, size_t *secptr, size_t *nsecptr) {
+  struct stat st;
+  if (fstat(r->fd, &st) != 0) {
+    return -1;
+  }
+  *secptr = (size_t) st.st_mtim.tv_sec;
+  *nsecptr = (size_t) st.st_mtim.tv_nsec;
+  return 0;
+}
+
+int reader_dispose(reader **rptr) {
+  if (*rptr == NULL) {
+    return 0;
+  }
+  if ((*rptr)->shared) {
+    free(*rptr);
+    *rptr = NULL;
+    return 0;
+  }
+  if ((*rptr)->map != NULL) {
+    munmap((*rptr)->map,
+        (*rptr)->follow ? (*rptr)->span : (*rptr)->mapsize);
+  }
+  free((*rptr)->buf);
+  int r = close((*rptr)->fd);
+  free(*rptr);
+  *rptr = NULL;
+  return r;
+}
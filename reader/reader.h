@@ -0,0 +1,103 @@
+//  reader.h : partie interface d'un module de lecture de fichiers texte par
+//    lignes. Les fichiers réguliers sont projetés en mémoire via mmap ; les
+//    autres (entrée standard, tubes...) sont lus par grands blocs via read.
+//    Les lignes sont fournies sous la forme d'un couple (adresse, longueur).
+
+#ifndef READER__H
+#define READER__H
+
+#include <stdlib.h>
+
+//  Fonctionnement général :
+//  - une ligne est terminée par le caractère '\n', par le caractère '\0' ou
+//      par la fin du fichier. Le terminateur ne fait pas partie de la ligne ;
+//  - une ligne vide située en fin de fichier, c'est-à-dire après le dernier
+//      terminateur, n'est pas fournie ;
+//  - les fonctions qui possèdent un paramètre de type « reader * » ou
+//      « reader ** » ont un comportement indéterminé lorsque ce paramètre ou
+//      sa déréférence n'est pas l'adresse d'un contrôleur préalablement
+//      renvoyée avec succès par la fonction reader_open et non révoquée depuis
+//      par la fonction reader_dispose.
+
+//  struct reader, reader : type et nom de type d'un contrôleur regroupant les
+//    informations nécessaires pour lire un fichier ligne par ligne.
+typedef struct reader reader;
+
+//  reader_open : tente d'ouvrir en lecture le fichier de nom fname, ou
+//    l'entrée standard si fname vaut NULL, et d'allouer les ressources
+//    nécessaires pour le lire. Renvoie NULL en cas d'échec. Renvoie sinon un
+//    pointeur vers le contrôleur associé au fichier.
+extern reader *reader_open(const char *fname);
+
+//  reader_next : tente de lire la ligne suivante du fichier associé à r. En
+//    cas de succès, affecte l'adresse de son premier caractère à *sptr, sa
+//    longueur à *lenptr et renvoie 1. Renvoie 0 si la fin du fichier est
+//    atteinte, -1 en cas d'erreur de lecture ou de dépassement de capacité.
+//    L'adresse affectée à *sptr n'est valide que jusqu'au prochain appel à
+//    reader_next.
+extern int reader_next(reader *r, const char **sptr, size_t *lenptr);
+
+//  reader_keep : s et len doivent être l'adresse et la longueur de la ligne
+//    fournie par le dernier appel à reader_next. Si le fichier associé à r est
+//    projeté en mémoire, renvoie l'adresse des len caractères de la ligne,
+//    valide jusqu'à l'appel de reader_dispose. Ceux-ci ne sont suivis d'aucun
+//    terminateur. Si le fichier est lu par blocs, renvoie NULL.
+extern const char *reader_keep(reader *r, const char *s, size_t len);
+
+//  reader_split : si le fichier associé à r est projeté en mémoire, tente de
+//    partager ses caractères non encore fournis en au plus n parties de
+//    longueurs voisines, d'au moins minsize caractères, chacune terminée par
+//    un terminateur, la dernière exceptée. En cas de succès, affecte à
+//    parts[0], ..., parts[k - 1] des contrôleurs lisant respectivement chacune
+//    des k parties dans l'ordre, considère le fichier associé à r comme lu
+//    et renvoie k, au moins égal à 2. Renvoie zéro si le fichier n'est pas
+//    projeté, si reader_follow a été appelée pour r, s'il ne peut être
+//    partagé en deux parties au moins ou en cas de dépassement de capacité.
+//    Les contrôleurs des parties partagent la projection de r : ils doivent
+//    être révoqués avant lui.
+extern size_t reader_split(reader *r, size_t n, size_t minsize,
+    reader **parts);
+
+//  reader_mapped : renvoie une valeur non nulle si le fichier associé à r est
+//    projeté en mémoire, zéro sinon.
+extern int reader_mapped(reader *r);
+
+//  reader_data : si le fichier associé à r est projeté en mémoire, renvoie
+//    l'adresse du début de la projection et affecte sa longueur à *lenptr.
+//    Renvoie NULL si le fichier n'est pas projeté.
+extern const char *reader_data(reader *r, size_t *lenptr);
+
+//  reader_follow : si le fichier associé à r est un fichier régulier lu par
+//    projection en mémoire, dont r n'est pas une partie, le considère comme
+//    susceptible de grandir par ajout : une dernière ligne non terminée n'est
+//    alors pas fournie par reader_next, mais le sera une fois terminée, après
+//    un appel à reader_resume. Sans effet sinon. Renvoie zéro en cas de
+//    succès, une valeur non nulle en cas d'échec de la projection.
+extern int reader_follow(reader *r);
+
+//  reader_resume : si reader_follow a été appelée pour r, tente de rendre
+//    disponibles à reader_next les caractères ajoutés au fichier associé à r
+//    depuis le dernier appel. Renvoie 1 si au moins une nouvelle ligne est
+//    terminée, 0 si aucune ne l'est ou si reader_follow n'a pas été appelée,
+//    -1 en cas d'erreur, de dépassement de capacité ou si le fichier a été
+//    tronqué. Les caractères ajoutés sont rendus accessibles dans la même
+//    projection : les adresses rendues par reader_keep restent valides.
+extern int reader_resume(reader *r);
+
+//  reader_size : renvoie la longueur du fichier associé à r si celui-ci est un
+//    fichier régulier, SIZE_MAX sinon.
+extern size_t reader_size(reader *r);
+
+//  reader_mtime : affecte à *secptr et *nsecptr la date de dernière
+//    modification, en secondes et nanosecondes, du fichier ouvert associé à r,
+//    indépendamment du nom sous lequel il a été ouvert. Renvoie une valeur non
+//    nulle en cas d'échec, zéro sinon.
+extern int reader_mtime(reader *r, size_t *secptr, size_t *nsecptr);
+
+//  reader_dispose : sans effet si *rptr vaut NULL. Libère sinon les
+//    ressources allouées à la gestion du fichier associé à *rptr, ferme le
+//    fichier, puis affecte NULL à *rptr. Renvoie une valeur non nulle si
+//    la fermeture échoue. Renvoie sinon zéro.
+extern int reader_dispose(reader **rptr);
+
+#endif
@@ -0,0 +1,263 @@
+//  report.c : partie implantation d'un module d'écriture et de lecture du
+//    format binaire des résultats de lnid.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "report.h"
+
+//  Nombre maximal d'octets de l'écriture d'un size_t en base 128
+#define REPORT__VARINT_MAX ((sizeof(size_t) * 8 + 6) / 7)
+
+#define REPORT__MAGIC_LENGTH 4
+
+//  Longueur initiale des tampons de lecture et facteur d'agrandissement
+#define REPORT__SIZE_INIT 64
+#define REPORT__MUL 2
+
+void report_put_value(output *out, size_t n) {
+  char code[REPORT__VARINT_MAX];
+  size_t len = 0;
+  while (n >= 0x80) {
+    code[len++] = (char) (n | 0x80);
+    n >>= 7;
+  }
+  code[len++] = (char) n;
+  output_mem(out, code, len);
+}
+
+void report_put_header(output *out, int mode, size_t nbfile,
+    char **filenames) {
+  output_mem(out, REPORT_MAGIC, REPORT__MAGIC_LENGTH);
+  output_char(out, REPORT_VERSION);
+  output_char(out, (char) mode);
+  report_put_value(out, nbfile);
+  for (size_t k = 0; k < nbfile; k++) {
+    size_t len = strlen(filenames[k]);
+    report_put_value(out, len);
+    output_mem(out, filenames[k], len);
+  }
+}
+
+void report_put_line(output *out, const char *s, size_t len,
+    size_t nbvalue) {
+  report_put_value(out, len + 1);
+  output_mem(out, s, len);
+  report_put_value(out, nbvalue);
+}
+
+void report_put_end(output *out) {
+  report_put_value(out, 0);
+}
+
+//  struct report, report : le composant f mémorise le fichier, mode le mode
+//    du résultat. Les noms des nbfile fichiers sont mémorisés dans filenames.
+//    La ligne du dernier enregistrement lu, de longueur length, est
+//    mémorisée dans le tampon line de longueur linesize, ses nbvalue valeurs
+//    dans le tableau values de longueur valuessize.
+struct report {
+  FILE *f;
+  int mode;
+  size_t nbfile;
+  char **filenames;
+  char *line;
+  size_t length;
+  size_t linesize;
+  size_t *values;
+  size_t nbvalue;
+  size_t valuessize;
+};
+
+//  report__get_value : tente de lire un entier dans le fichier de r et de
+//    l'affecter à *nptr. Renvoie zéro en cas de succès, une valeur non nulle
+//    sinon.
+static int report__get_value(report *r, size_t *nptr) {
+  size_t n = 0;
+  unsigned shift = 0;
+  int c;
+  do {
+    c = getc(r->f);
+    if (c == EOF || shift >= sizeof(size_t) * 8) {
+      return -1;
+    }
+    n |= (size_t) (c & 0x7f) << shift;
+    shift += 7;
+  } while ((c & 0x80) != 0);
+  *nptr = n;
+  return 0;
+}
+
+//  report__get_string : tente de lire une chaîne de longueur len dans le
+//    fichier de r. Renvoie NULL en cas d'échec. Renvoie sinon l'adresse
+//    d'une copie, terminée par '\0', allouée dynamiquement.
+static char *report__get_string(report *r, size_t len) {
+  if (len == SIZE_MAX) {
+    return NULL;
+  }
+  char *s = malloc(len + 1);
+  if (s == NULL) {
+    return NULL;
+  }
+  if (fread(s, 1, len, r->f) != len) {
+    free(s);
+    return NULL;
+  }
+  s[len] = '\0';
+  return s;
+}
+
+report *report_open(const char *fname) {
+  FILE *f = stdin;
+  if (fname != NULL && (f = fopen(fname, "rb")) == NULL) {
+    return NULL;
+  }
+  report *r = malloc(sizeof *r);
+  if (r == NULL) {
+    if (f != stdin) {
+      fclose(f);
+    }
+    return NULL;
+  }
+  r->f = f;
+  r->nbfile = 0;
+  r->filenames = NULL;
+  r->line = NULL;
+  r->length = 0;
+  r->linesize = 0;
+  r->values = NULL;
+  r->nbvalue = 0;
+  r->valuessize = 0;
+  char magic[REPORT__MAGIC_LENGTH];
+  size_t nbfile;
+  if (fread(magic, 1, REPORT__MAGIC_LENGTH, f) != REPORT__MAGIC_LENGTH
+      || memcmp(magic, REPORT_MAGIC, REPORT__MAGIC_LENGTH) != 0
+      || getc(f) != REPORT_VERSION
+      || (r->mode = getc(f)) == EOF
+      || (r->mode != REPORT_NUMBERS && r->mode != REPORT_COUNT
+      && r->mode != REPORT_MULT)
+      || report__get_value(r, &nbfile) != 0
+      || nbfile > SIZE_MAX / sizeof *r->filenames) {
+    report_dispose(&r);
+    return NULL;
+  }
+  r->filenames = malloc(nbfile * sizeof *r->filenames);
+  if (r->filenames == NULL && nbfile != 0) {
+    report_dispose(&r);
+    return NULL;
+  }
+  for (; r->nbfile < nbfile; r->nbfile++) {
+    size_t len;
+    if (report__get_value(r, &len) != 0
+        || (r->filenames[r->nbfile] = report__get_string(r, len)) == NULL) {
+      report_dispose(&r);
+      return NULL;
+    }
+  }
+  return r;
+}
+
+int report_mode(report *r) {
+  return r->mode;
+}
+
+size_t report_nbfile(report *r) {
+  return r->nbfile;
+}
+
+const char *report_filename(report *r, size_t k) {
+  return r->filenames[k];
+}
+
+int report_next(report *r) {
+  size_t len;
+  size_t nbvalue;
+  if (report__get_value(r, &len) != 0) {
+    return -1;
+  }
+  if (len == 0) {
+    return 0;
+  }
+  len--;
+  if (len >= r->linesize) {
+    size_t size = r->linesize == 0 ? REPORT__SIZE_INIT : r->linesize;
+    while (size <= len) {
+      if (size > SIZE_MAX / REPORT__MUL) {
+        return -1;
+      }
+      size *= REPORT__MUL;
+    }
+    char *t = realloc(r->line, size);
+    if (t == NULL) {
+      return -1;
+    }
+    r->line = t;
+    r->linesize = size;
+  }
+  if (fread(r->line, 1, len, r->f) != len
+      || report__get_value(r, &nbvalue) != 0) {
+    return -1;
+  }
+  r->line[len] = '\0';
+  r->length = len;
+  r->nbvalue = 0;
+  size_t n = 0;
+  for (size_t k = 0; k < nbvalue; k++) {
+    size_t v;
+    if (report__get_value(r, &v) != 0) {
+      return -1;
+    }
+    if (r->nbvalue == r->valuessize) {
+      size_t size = r->valuessize == 0 ? REPORT__SIZE_INIT
+          : r->valuessize * REPORT__MUL;
+      if (size > SIZE_MAX / sizeof *r->values) {
+        return -1;
+      }
+      size_t *t = realloc(r->values, size * sizeof *r->values);
+      if (t == NULL) {
+        return -1;
+      }
+      r->values = t;
+      r->valuessize = size;
+    }
+    n = r->mode == REPORT_NUMBERS ? n + v : v;
+    r->values[r->nbvalue] = n;
+    r->nbvalue++;
+  }
+  return 1;
+}
+
+const char *report_line(report *r) {
+  return r->line;
+}
+
+size_t report_length(report *r) {
+  return r->length;
+}
+
+size_t report_nbvalue(report *r) {
+  return r->nbvalue;
+}
+
+size_t report_value(report *r, size_t k) {
+  return r->values[k];
+}
+
+int report_dispose(report **rptr) {
+  if (*rptr == NULL) {
+    return 0;
+  }
+  report *r = *rptr;
+  int res = 0;
+  if (r->f != stdin && fclose(r->f) != 0) {
+    res = -1;
+  }
+  for (size_t k = 0; k < r->nbfile; k++) {
+    free(r->filenames[k]);
+  }
+  free(r->filenames);
+  free(r->line);
+  free(r->values);
+  free(r);
+  *rptr = NULL;
+  return res;
+}
@@ -0,0 +1,102 @@
+//  report.h : partie interface d'un module d'écriture et de lecture du format
+//    binaire des résultats de lnid.
+
+#ifndef REPORT__H
+#define REPORT__H
+
+#include <stdlib.h>
+#include "output.h"
+
+//  Format : tous les entiers sont écrits en base 128, sept bits par octet en
+//    commençant par les poids faibles, le bit de poids fort de chaque octet
+//    valant 1 sauf pour le dernier.
+//  - en-tête : les quatre caractères REPORT_MAGIC, un octet de version valant
+//      REPORT_VERSION, un octet de mode, le nombre de fichiers puis, pour
+//      chaque fichier, la longueur de son nom suivie des caractères du nom ;
+//  - puis, pour chaque ligne, dans l'ordre du tri : sa longueur augmentée de
+//      1, ses caractères, le nombre de valeurs et les valeurs ;
+//  - enfin l'entier 0.
+//  Selon le mode, les valeurs sont :
+//  - REPORT_NUMBERS : les numéros de la ligne dans l'unique fichier, le
+//      premier puis les différences entre deux numéros successifs ;
+//  - REPORT_COUNT : le nombre d'occurrences de la ligne dans l'unique
+//      fichier ;
+//  - REPORT_MULT : le nombre d'occurrences de la ligne dans chacun des
+//      fichiers, dans l'ordre de l'en-tête.
+
+#define REPORT_MAGIC "LNID"
+#define REPORT_VERSION 1
+
+#define REPORT_NUMBERS 0
+#define REPORT_COUNT 1
+#define REPORT_MULT 2
+
+//  report_put_header : écrit sur out l'en-tête d'un résultat de mode mode
+//    portant sur les nbfile fichiers de noms filenames[0], ...,
+//    filenames[nbfile - 1].
+extern void report_put_header(output *out, int mode, size_t nbfile,
+    char **filenames);
+
+//  report_put_line : écrit sur out le début de l'enregistrement de la ligne s
+//    de longueur len, qui sera suivi de nbvalue valeurs.
+extern void report_put_line(output *out, const char *s, size_t len,
+    size_t nbvalue);
+
+//  report_put_value : écrit sur out la valeur n.
+extern void report_put_value(output *out, size_t n);
+
+//  report_put_end : écrit sur out la fin du résultat.
+extern void report_put_end(output *out);
+
+//  Lecture : les fonctions qui possèdent un paramètre de type « report * » ou
+//    « report ** » ont un comportement indéterminé lorsque ce paramètre ou sa
+//    déréférence n'est pas l'adresse d'un contrôleur préalablement renvoyée
+//    avec succès par la fonction report_open et non révoquée depuis par la
+//    fonction report_dispose.
+
+//  struct report, report : type et nom de type d'un contrôleur regroupant les
+//    informations nécessaires pour lire un résultat enregistrement par
+//    enregistrement.
+typedef struct report report;
+
+//  report_open : tente d'ouvrir en lecture le fichier de nom fname, ou l'entrée
+//    standard si fname vaut NULL, et d'en lire l'en-tête. Renvoie NULL en cas
+//    d'échec, d'en-tête invalide ou de dépassement de capacité. Renvoie sinon
+//    un pointeur vers le contrôleur associé au fichier.
+extern report *report_open(const char *fname);
+
+//  report_mode : renvoie le mode du résultat associé à r.
+extern int report_mode(report *r);
+
+//  report_nbfile, report_filename : renvoient respectivement le nombre de
+//    fichiers et le nom du fichier d'indice k du résultat associé à r.
+extern size_t report_nbfile(report *r);
+extern const char *report_filename(report *r, size_t k);
+
+//  report_next : tente de lire l'enregistrement suivant du résultat associé
+//    à r. Renvoie 1 en cas de succès, 0 si la fin du résultat est atteinte,
+//    -1 en cas d'erreur de lecture, de format invalide ou de dépassement de
+//    capacité.
+extern int report_next(report *r);
+
+//  report_line, report_length : renvoient respectivement l'adresse et la
+//    longueur de la ligne du dernier enregistrement lu par report_next. La
+//    ligne est terminée par '\0' ; elle n'est valide que jusqu'au prochain
+//    appel à report_next.
+extern const char *report_line(report *r);
+extern size_t report_length(report *r);
+
+//  report_nbvalue, report_value : renvoient respectivement le nombre de
+//    valeurs et la valeur d'indice k du dernier enregistrement lu par
+//    report_next. Dans le mode REPORT_NUMBERS, les valeurs sont les numéros
+//    de ligne eux-mêmes, et non leurs différences.
+extern size_t report_nbvalue(report *r);
+extern size_t report_value(report *r, size_t k);
+
+//  report_dispose : sans effet si *rptr vaut NULL. Libère sinon les
+//    ressources allouées à la gestion du résultat associé à *rptr, ferme le
+//    fichier, puis affecte NULL à *rptr. Renvoie une valeur non nulle si la
+//    fermeture échoue. Renvoie sinon zéro.
+extern int report_dispose(report **rptr);
+
+#endif
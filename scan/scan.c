@@ -0,0 +1,91 @@
+//  scan.c : partie implantation d'un module de recherche des terminateurs de
+//    ligne dans une zone mémoire.
+
+#include <stddef.h>
+#include "scan.h"
+
+#if defined __SSE2__
+#include <immintrin.h>
+#define SCAN__SSE2 1
+#if defined __GNUC__
+#define SCAN__AVX2 1
+#endif
+#endif
+
+//  scan__scalar : recherche caractère par caractère.
+static const char *scan__scalar(const char *p, const char *end) {
+  while (p < end && *p != '\n' && *p != '\0') {
+    ++p;
+  }
+  return p;
+}
+
+#if defined SCAN__SSE2
+
+//  scan__sse2 : recherche par blocs de 16 caractères. Le masque obtenu par
+//    comparaison avec '\n' et '\0' donne directement la position du premier
+//    terminateur du bloc.
+static const char *scan__sse2(const char *p, const char *end) {
+  const __m128i nl = _mm_set1_epi8('\n');
+  const __m128i nul = _mm_setzero_si128();
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, nul));
+    unsigned int mask = (unsigned int) _mm_movemask_epi8(m);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+  return scan__scalar(p, end);
+}
+
+#endif
+
+#if defined SCAN__AVX2
+
+//  scan__avx2 : recherche par blocs de 32 caractères, la fin de zone étant
+//    confiée à scan__sse2.
+__attribute__((target("avx2")))
+static const char *scan__avx2(const char *p, const char *end) {
+  const __m256i nl = _mm256_set1_epi8('\n');
+  const __m256i nul = _mm256_setzero_si256();
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) p);
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, nl),
+        _mm256_cmpeq_epi8(v, nul));
+    unsigned int mask = (unsigned int) _mm256_movemask_epi8(m);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return scan__sse2(p, end);
+}
+
+#endif
+
+//  scan__impl : implantation utilisée par scan_eol.
+#if defined SCAN__SSE2
+static const char *(*scan__impl)(const char *, const char *) = scan__sse2;
+#else
+static const char *(*scan__impl)(const char *, const char *) = scan__scalar;
+#endif
+
+#if defined SCAN__AVX2
+
+//  scan__select : choisit, au chargement du programme, scan__avx2 pour
+//    scan__impl si le processeur gère AVX2.
+__attribute__((constructor))
+static void scan__select(void) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    scan__impl = scan__avx2;
+  }
+}
+
+#endif
+
+const char *scan_eol(const char *p, const char *end) {
+  return scan__impl(p, end);
+}
@@ -0,0 +1,16 @@
+//  scan.h : partie interface d'un module de recherche des terminateurs de
+//    ligne dans une zone mémoire. Les caractères '\n' et '\0' sont tous deux
+//    considérés comme des terminateurs.
+
+//  Le module utilise des instructions vectorielles lorsque la plateforme le
+//    permet : SSE2 sur x86-64, AVX2 si le processeur le gère, ce qui est testé
+//    une fois pour toutes au chargement du programme. Une version scalaire est utilisée sinon.
+
+#ifndef SCAN__H
+#define SCAN__H
+
+//  scan_eol : renvoie l'adresse du premier terminateur de ligne figurant dans
+//    la zone d'adresses [p, end[. Renvoie end si la zone n'en contient aucun.
+extern const char *scan_eol(const char *p, const char *end);
+
+#endif
@@ -0,0 +1,118 @@
+//  shtable.c : partie implantation d'un module de table de hachage partagée
+//    en parties indépendantes.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdint.h>
+#include "shtable.h"
+
+#define SHTABLE__SIZE_WIDTH (sizeof(size_t) * 8)
+
+//  struct shard, shard : le composant mutex verrouille la partie ; ht, ha et
+//    a sont sa table, son fourre-tout et sa région. Les parties sont alignées
+//    sur des lignes de cache distinctes pour que les verrous de deux parties
+//    voisines ne se disputent pas la même ligne.
+struct shard {
+  _Alignas(64) pthread_mutex_t mutex;
+  hashtable *ht;
+  holdall *ha;
+  arena *a;
+};
+
+//  struct shtable, shtable : le tableau shards de longueur 2^lbnshard
+//    mémorise les parties de la table.
+struct shtable {
+  size_t lbnshard;
+  shard *shards;
+};
+
+shtable *shtable_empty(int (*compar)(const void *, const void *),
+    size_t (*hashfun)(const void *), size_t nbshard) {
+  shtable *st = malloc(sizeof *st);
+  if (st == NULL) {
+    return NULL;
+  }
+  st->lbnshard = 0;
+  while (st->lbnshard < SHTABLE__SIZE_WIDTH - 1
+      && ((size_t) 1 << st->lbnshard) < nbshard) {
+    st->lbnshard++;
+  }
+  size_t n = (size_t) 1 << st->lbnshard;
+  st->shards = aligned_alloc(_Alignof(shard), n * sizeof(shard));
+  if (st->shards == NULL) {
+    free(st);
+    return NULL;
+  }
+  for (size_t k = 0; k < n; k++) {
+    shard *sh = &st->shards[k];
+    pthread_mutex_init(&sh->mutex, NULL);
+    sh->ht = hashtable_empty(compar, hashfun);
+    sh->ha = holdall_empty();
+    sh->a = arena_empty();
+  }
+  for (size_t k = 0; k < n; k++) {
+    shard *sh = &st->shards[k];
+    if (sh->ht == NULL || sh->ha == NULL || sh->a == NULL) {
+      shtable_dispose(&st);
+      return NULL;
+    }
+  }
+  return st;
+}
+
+void shtable_dispose(shtable **stptr) {
+  if (*stptr == NULL) {
+    return;
+  }
+  size_t n = (size_t) 1 << (*stptr)->lbnshard;
+  for (size_t k = 0; k < n; k++) {
+    shard *sh = &(*stptr)->shards[k];
+    pthread_mutex_destroy(&sh->mutex);
+    hashtable_dispose(&sh->ht);
+    holdall_dispose(&sh->ha);
+    arena_dispose(&sh->a);
+  }
+  free((*stptr)->shards);
+  free(*stptr);
+  *stptr = NULL;
+}
+
+size_t shtable_nbshard(shtable *st) {
+  return (size_t) 1 << st->lbnshard;
+}
+
+shard *shtable_nth(shtable *st, size_t k) {
+  return &st->shards[k];
+}
+
+shard *shtable_shard(shtable *st, size_t hashval) {
+  return &st->shards[shtable_index(st, hashval)];
+}
+
+size_t shtable_index(shtable *st, size_t hashval) {
+  if (st->lbnshard == 0) {
+    return 0;
+  }
+  return hashval >> (SHTABLE__SIZE_WIDTH - st->lbnshard);
+}
+
+void shard_lock(shard *sh) {
+  pthread_mutex_lock(&sh->mutex);
+}
+
+void shard_unlock(shard *sh) {
+  pthread_mutex_unlock(&sh->mutex);
+}
+
+hashtable *shard_hashtable(shard *sh) {
+  return sh->ht;
+}
+
+holdall *shard_holdall(shard *sh) {
+  return sh->ha;
+}
+
+arena *shard_arena(shard *sh) {
+  return sh->a;
+}
@@ -0,0 +1,76 @@
+//  shtable.h : partie interface d'un module de table de hachage partagée en
+//    parties (shards) indépendantes, utilisable par plusieurs fils
+//    d'exécution. Chaque partie regroupe un verrou, une table de hachage, un
+//    fourre-tout et une région ; la partie d'une clé est déterminée par les
+//    bits de poids fort de sa valeur de hachage.
+
+#ifndef SHTABLE__H
+#define SHTABLE__H
+
+#include <stdlib.h>
+#include "arena.h"
+#include "hashtable.h"
+#include "holdall.h"
+
+//  Fonctionnement général :
+//  - les fonctions qui possèdent un paramètre de type « shtable * » ou
+//      « shtable ** » ont un comportement indéterminé lorsque ce paramètre ou
+//      sa déréférence n'est pas l'adresse d'un contrôleur préalablement
+//      renvoyée avec succès par la fonction shtable_empty et non révoquée
+//      depuis par la fonction shtable_dispose ;
+//  - les fonctions qui possèdent un paramètre de type « shard * » ont un
+//      comportement indéterminé lorsque ce paramètre n'est pas l'adresse d'une
+//      partie renvoyée par shtable_shard ou shtable_nth pour une table non
+//      révoquée depuis ;
+//  - les tables, fourre-tout et régions d'une partie ne doivent être utilisés
+//      par plusieurs fils d'exécution qu'entre un appel à shard_lock et
+//      l'appel à shard_unlock correspondant.
+
+//  struct shtable, shtable : type et nom de type d'un contrôleur regroupant
+//    les informations nécessaires pour gérer une table partagée.
+typedef struct shtable shtable;
+
+//  struct shard, shard : type et nom de type d'une partie de table partagée.
+typedef struct shard shard;
+
+//  shtable_empty : tente d'allouer les ressources nécessaires pour gérer une
+//    nouvelle table partagée initialement vide d'au moins nbshard parties,
+//    leur nombre étant arrondi à une puissance de deux. Les fonctions compar
+//    et hashfun sont celles des tables de hachage des parties. Renvoie NULL
+//    en cas de dépassement de capacité. Renvoie sinon un pointeur vers le
+//    contrôleur associé à la table.
+extern shtable *shtable_empty(int (*compar)(const void *, const void *),
+    size_t (*hashfun)(const void *), size_t nbshard);
+
+//  shtable_dispose : sans effet si *stptr vaut NULL. Libère sinon les
+//    ressources allouées à la gestion de la table partagée associée à *stptr,
+//    y compris les tables, fourre-tout et régions de ses parties, puis
+//    affecte NULL à *stptr.
+extern void shtable_dispose(shtable **stptr);
+
+//  shtable_nbshard : renvoie le nombre de parties de la table associée à st.
+extern size_t shtable_nbshard(shtable *st);
+
+//  shtable_nth : renvoie la partie d'indice k de la table associée à st, k
+//    devant être strictement inférieur à shtable_nbshard(st).
+extern shard *shtable_nth(shtable *st, size_t k);
+
+//  shtable_shard : renvoie la partie de la table associée à st à laquelle
+//    appartiennent les clés de valeur de hachage hashval.
+extern shard *shtable_shard(shtable *st, size_t hashval);
+
+//  shtable_index : renvoie l'indice de la partie de la table associée à st à
+//    laquelle appartiennent les clés de valeur de hachage hashval.
+extern size_t shtable_index(shtable *st, size_t hashval);
+
+//  shard_lock, shard_unlock : verrouille, déverrouille la partie sh.
+extern void shard_lock(shard *sh);
+extern void shard_unlock(shard *sh);
+
+//  shard_hashtable, shard_holdall, shard_arena : renvoient respectivement la
+//    table de hachage, le fourre-tout et la région de la partie sh.
+extern hashtable *shard_hashtable(shard *sh);
+extern holdall *shard_holdall(shard *sh);
+extern arena *shard_arena(shard *sh);
+
+#endif
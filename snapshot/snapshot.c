@@ -0,0 +1,345 @@
+//  snapshot.c : partie implantation d'un module d'enregistrement sur disque
+//    de la table des lignes de lnid.
+//
+//  Format : les entiers sont écrits en base 128, sept bits par octet en
+//    commençant par les poids faibles, le bit de poids fort de chaque octet
+//    valant 1 sauf pour le dernier. Les chaînes sont écrites précédées de leur
+//    longueur et suivies de '\0', pour être utilisables en place.
+//  - en-tête : les quatre caractères SNAPSHOT__MAGIC, un octet de version, le
+//      germe, la description des options, le nombre de fichiers puis, pour
+//      chaque fichier, son nom, sa taille, sa date et la valeur de hachage de
+//      son contenu ;
+//  - puis des sections de lignes, chacune terminée par l'entier 0 et
+//      contenant, pour chaque ligne : sa longueur augmentée de 1, ses
+//      caractères, '\0', sa valeur de hachage, la longueur de ses données puis
+//      celles-ci ;
+//  - enfin la valeur de hachage, de germe nul, de tout ce qui précède, sur
+//      SNAPSHOT__CHECK_LENGTH octets en commençant par les poids faibles.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+#include "hash.h"
+
+#define SNAPSHOT__MAGIC "LNIX"
+#define SNAPSHOT__MAGIC_LENGTH 4
+#define SNAPSHOT__VERSION 2
+#define SNAPSHOT__VARINT_MAX ((sizeof(size_t) * 8 + 6) / 7)
+#define SNAPSHOT__SUFFIX ".tmp"
+#define SNAPSHOT__CHECK_LENGTH 8
+
+//  struct snapshot, snapshot : projection map de longueur mapsize, dont les
+//    octets non encore lus sont ceux de l'intervalle [cur, end[. Les autres
+//    composants mémorisent l'en-tête, les noms de fichiers étant repérés
+//    dans la projection.
+struct snapshot {
+  unsigned char *map;
+  size_t mapsize;
+  const unsigned char *cur;
+  const unsigned char *end;
+  size_t seed;
+  const char *options;
+  size_t nbfile;
+  const char **filenames;
+  fileinfo *infos;
+};
+
+//  snapshot__get : tente de lire un entier de s et de l'affecter à *dptr.
+//    Renvoie zéro en cas de succès, une valeur non nulle sinon.
+static int snapshot__get(snapshot *s, size_t *dptr) {
+  const unsigned char *p = s->cur;
+  size_t d = 0;
+  unsigned int shift = 0;
+  do {
+    if (p == s->end || shift >= sizeof(size_t) * 8) {
+      return -1;
+    }
+    d |= (size_t) (*p & 0x7f) << shift;
+    shift += 7;
+  } while ((*p++ & 0x80) != 0);
+  s->cur = p;
+  *dptr = d;
+  return 0;
+}
+
+//  snapshot__get_string : tente de lire une chaîne de s. Renvoie NULL en cas
+//    d'échec, l'adresse de la chaîne dans la projection sinon. Affecte sa
+//    longueur à *lenptr si lenptr ne vaut pas NULL.
+static char *snapshot__get_string(snapshot *s, size_t *lenptr) {
+  size_t len;
+  if (snapshot__get(s, &len) != 0 || len >= (size_t) (s->end - s->cur)
+      || s->cur[len] != '\0') {
+    return NULL;
+  }
+  char *str = (char *) s->map + (s->cur - s->map);
+  s->cur += len + 1;
+  if (lenptr != NULL) {
+    *lenptr = len;
+  }
+  return str;
+}
+
+//  snapshot__check : renvoie la valeur de hachage de germe nul des n octets
+//    p, ramenée à SNAPSHOT__CHECK_LENGTH octets.
+static uint64_t snapshot__check(const void *p, size_t n) {
+  return (uint64_t) hash_bytes(p, n, 0);
+}
+
+snapshot *snapshot_open(const char *fname) {
+  int fd = open(fname, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0
+      || (unsigned long long) st.st_size > SIZE_MAX) {
+    close(fd);
+    return NULL;
+  }
+  size_t n = (size_t) st.st_size;
+  void *p = mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    return NULL;
+  }
+  snapshot *s = malloc(sizeof *s);
+  if (s == NULL) {
+    munmap(p, n);
+    return NULL;
+  }
+  s->map = p;
+  s->mapsize = n;
+  s->cur = s->map;
+  s->end = s->map + n;
+  s->nbfile = 0;
+  s->filenames = NULL;
+  s->infos = NULL;
+  size_t nbfile;
+  if (n < SNAPSHOT__MAGIC_LENGTH + 1 + SNAPSHOT__CHECK_LENGTH) {
+    goto invalid;
+  }
+  s->end -= SNAPSHOT__CHECK_LENGTH;
+  if (memcmp(s->cur, SNAPSHOT__MAGIC, SNAPSHOT__MAGIC_LENGTH) != 0
+      || s->cur[SNAPSHOT__MAGIC_LENGTH] != SNAPSHOT__VERSION) {
+    goto invalid;
+  }
+  s->cur += SNAPSHOT__MAGIC_LENGTH + 1;
+  if (snapshot__get(s, &s->seed) != 0
+      || (s->options = snapshot__get_string(s, NULL)) == NULL
+      || snapshot__get(s, &nbfile) != 0
+      || nbfile > (size_t) (s->end - s->cur)) {
+    goto invalid;
+  }
+  s->filenames = malloc(sizeof *s->filenames * (nbfile == 0 ? 1 : nbfile));
+  s->infos = malloc(sizeof *s->infos * (nbfile == 0 ? 1 : nbfile));
+  if (s->filenames == NULL || s->infos == NULL) {
+    goto invalid;
+  }
+  for (; s->nbfile < nbfile; s->nbfile++) {
+    fileinfo *fi = &s->infos[s->nbfile];
+    if ((s->filenames[s->nbfile] = snapshot__get_string(s, NULL)) == NULL
+        || snapshot__get(s, &fi->size) != 0
+        || snapshot__get(s, &fi->mtime_sec) != 0
+        || snapshot__get(s, &fi->mtime_nsec) != 0
+        || snapshot__get(s, &fi->hash) != 0) {
+      goto invalid;
+    }
+  }
+  posix_madvise(s->map, s->mapsize, POSIX_MADV_SEQUENTIAL);
+  return s;
+invalid:
+  snapshot_dispose(&s);
+  return NULL;
+}
+
+int snapshot_verify(snapshot *s) {
+  uint64_t check = 0;
+  for (size_t k = SNAPSHOT__CHECK_LENGTH; k > 0; k--) {
+    check = check << 8 | s->end[k - 1];
+  }
+  return check != snapshot__check(s->map, (size_t) (s->end - s->map));
+}
+
+size_t snapshot_seed(snapshot *s) {
+  return s->seed;
+}
+
+const char *snapshot_options(snapshot *s) {
+  return s->options;
+}
+
+size_t snapshot_nbfile(snapshot *s) {
+  return s->nbfile;
+}
+
+const char *snapshot_filename(snapshot *s, size_t k) {
+  return s->filenames[k];
+}
+
+const fileinfo *snapshot_fileinfo(snapshot *s, size_t k) {
+  return &s->infos[k];
+}
+
+int snapshot_next(snapshot *s, char **sptr, size_t *lenptr,
+    size_t *hashptr, const void **dataptr, size_t *nptr) {
+  size_t len;
+  if (snapshot__get(s, &len) != 0) {
+    return -1;
+  }
+  if (len == 0) {
+    return 0;
+  }
+  len--;
+  if (len >= (size_t) (s->end - s->cur) || s->cur[len] != '\0') {
+    return -1;
+  }
+  *sptr = (char *) s->map + (s->cur - s->map);
+  *lenptr = len;
+  s->cur += len + 1;
+  size_t n;
+  if (snapshot__get(s, hashptr) != 0 || snapshot__get(s, &n) != 0
+      || n > (size_t) (s->end - s->cur)) {
+    return -1;
+  }
+  *dataptr = s->cur;
+  *nptr = n;
+  s->cur += n;
+  return 1;
+}
+
+void snapshot_dispose(snapshot **sptr) {
+  if (*sptr == NULL) {
+    return;
+  }
+  munmap((*sptr)->map, (*sptr)->mapsize);
+  free((*sptr)->filenames);
+  free((*sptr)->infos);
+  free(*sptr);
+  *sptr = NULL;
+}
+
+//  snapshot__put : écrit sur out l'entier d.
+static void snapshot__put(output *out, size_t d) {
+  char code[SNAPSHOT__VARINT_MAX];
+  size_t len = 0;
+  while (d >= 0x80) {
+    code[len++] = (char) (d | 0x80);
+    d >>= 7;
+  }
+  code[len++] = (char) d;
+  output_mem(out, code, len);
+}
+
+//  snapshot__put_string : écrit sur out la chaîne s de longueur len.
+static void snapshot__put_string(output *out, const char *s, size_t len) {
+  snapshot__put(out, len);
+  output_mem(out, s, len);
+  output_char(out, '\0');
+}
+
+void snapshot_put_end(output *out) {
+  snapshot__put(out, 0);
+}
+
+void snapshot_put_line(output *out, const char *s, size_t len,
+    size_t hashval, const void *data, size_t n) {
+  snapshot__put(out, len + 1);
+  output_mem(out, s, len);
+  output_char(out, '\0');
+  snapshot__put(out, hashval);
+  snapshot__put(out, n);
+  output_mem(out, data, n);
+}
+
+//  snapshot__seal : tente d'ajouter en fin du fichier complet de descripteur
+//    fd, ouvert en lecture et écriture, la valeur de hachage de son contenu.
+//    Renvoie zéro en cas de succès, une valeur non nulle sinon.
+static int snapshot__seal(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0
+      || (unsigned long long) st.st_size > SIZE_MAX) {
+    return -1;
+  }
+  size_t n = (size_t) st.st_size;
+  void *p = mmap(NULL, n, PROT_READ, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    return -1;
+  }
+  uint64_t check = snapshot__check(p, n);
+  munmap(p, n);
+  unsigned char code[SNAPSHOT__CHECK_LENGTH];
+  for (size_t k = 0; k < SNAPSHOT__CHECK_LENGTH; k++) {
+    code[k] = (unsigned char) (check >> (8 * k));
+  }
+  size_t done = 0;
+  while (done < SNAPSHOT__CHECK_LENGTH) {
+    ssize_t w = write(fd, code + done, SNAPSHOT__CHECK_LENGTH - done);
+    if (w < 0 && errno != EINTR) {
+      return -1;
+    }
+    if (w > 0) {
+      done += (size_t) w;
+    }
+  }
+  return 0;
+}
+
+int snapshot_save(const char *fname, size_t seed, const char *options,
+    size_t nbfile, char **filenames, const fileinfo *infos,
+    int (*fill)(output *out, void *context), void *context) {
+  size_t len = strlen(fname);
+  char *tmp = malloc(len + sizeof SNAPSHOT__SUFFIX);
+  if (tmp == NULL) {
+    return -1;
+  }
+  memcpy(tmp, fname, len);
+  memcpy(tmp + len, SNAPSHOT__SUFFIX, sizeof SNAPSHOT__SUFFIX);
+  int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) {
+    free(tmp);
+    return -1;
+  }
+  output *out = output_open(fd);
+  int r = -1;
+  if (out != NULL) {
+    output_mem(out, SNAPSHOT__MAGIC, SNAPSHOT__MAGIC_LENGTH);
+    output_char(out, SNAPSHOT__VERSION);
+    snapshot__put(out, seed);
+    snapshot__put_string(out, options, strlen(options));
+    snapshot__put(out, nbfile);
+    for (size_t k = 0; k < nbfile; k++) {
+      snapshot__put_string(out, filenames[k], strlen(filenames[k]));
+      snapshot__put(out, infos[k].size);
+      snapshot__put(out, infos[k].mtime_sec);
+      snapshot__put(out, infos[k].mtime_nsec);
+      snapshot__put(out, infos[k].hash);
+    }
+    r = fill(out, context);
+    snapshot_put_end(out);
+    if (output_dispose(&out) != 0) {
+      r = -1;
+    }
+  }
+  if (r == 0) {
+    r = snapshot__seal(fd);
+  }
+  if (close(fd) != 0) {
+    r = -1;
+  }
+  if (r == 0 && rename(tmp, fname) != 0) {
+    r = -1;
+  }
+  if (r != 0) {
+    unlink(tmp);
+  }
+  free(tmp);
+  return r;
+}
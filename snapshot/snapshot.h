@@ -0,0 +1,103 @@
+//  snapshot.h : partie interface d'un module d'enregistrement sur disque de la
+//    table des lignes de lnid, afin qu'une exécution ultérieure sur les mêmes
+//    fichiers ne relise que ceux qui ont changé. Le fichier d'index est relu
+//    par projection en mémoire : les chaînes qu'il contient sont utilisables
+//    en place, sans être recopiées. Les lignes sont réparties en sections,
+//    dont chacune peut être lue sans les suivantes. Un index dont le contenu
+//    a été altéré est détecté par sa valeur de hachage et ignoré.
+
+#ifndef SNAPSHOT__H
+#define SNAPSHOT__H
+
+#include <stdlib.h>
+#include "output.h"
+
+//  Fonctionnement général :
+//  - les fonctions qui possèdent un paramètre de type « snapshot * » ou
+//      « snapshot ** » ont un comportement indéterminé lorsque ce paramètre ou
+//      sa déréférence n'est pas l'adresse d'un contrôleur préalablement
+//      renvoyée avec succès par la fonction snapshot_open et non révoquée
+//      depuis par la fonction snapshot_dispose ;
+//  - les chaînes fournies par un contrôleur restent valides jusqu'à sa
+//      révocation.
+
+//  struct fileinfo, fileinfo : taille size, date de dernière modification, en
+//    secondes mtime_sec et nanosecondes mtime_nsec, et valeur de hachage hash
+//    du contenu d'un fichier. La taille d'un fichier qui n'est pas régulier
+//    vaut SIZE_MAX.
+typedef struct {
+  size_t size;
+  size_t mtime_sec;
+  size_t mtime_nsec;
+  size_t hash;
+} fileinfo;
+
+//  struct snapshot, snapshot : type et nom de type d'un contrôleur regroupant
+//    les informations nécessaires pour relire un fichier d'index.
+typedef struct snapshot snapshot;
+
+//  snapshot_open : tente de projeter en mémoire le fichier d'index de nom
+//    fname et d'en lire l'en-tête, sans lire les lignes. Renvoie NULL en cas
+//    d'échec, d'en-tête invalide ou de dépassement de capacité. Renvoie sinon
+//    un pointeur vers le contrôleur associé.
+extern snapshot *snapshot_open(const char *fname);
+
+//  snapshot_verify : calcule la valeur de hachage de tout l'index associé à
+//    s, en un temps proportionnel à sa taille, et la compare à celle
+//    enregistrée. Renvoie une valeur non nulle si elles diffèrent, zéro
+//    sinon. Les lignes d'un index qui n'a pas été vérifié sont lues sans
+//    sortir de la projection, mais leur contenu peut avoir été altéré.
+extern int snapshot_verify(snapshot *s);
+
+//  snapshot_seed, snapshot_options : renvoient respectivement le germe de
+//    hachage et la description des options enregistrés dans l'index associé
+//    à s.
+extern size_t snapshot_seed(snapshot *s);
+extern const char *snapshot_options(snapshot *s);
+
+//  snapshot_nbfile, snapshot_filename, snapshot_fileinfo : renvoient
+//    respectivement le nombre de fichiers, le nom et les informations du
+//    fichier d'indice k enregistrés dans l'index associé à s.
+extern size_t snapshot_nbfile(snapshot *s);
+extern const char *snapshot_filename(snapshot *s, size_t k);
+extern const fileinfo *snapshot_fileinfo(snapshot *s, size_t k);
+
+//  snapshot_next : tente de lire la ligne suivante de l'index associé à s. En
+//    cas de succès, affecte l'adresse de sa valeur, terminée par '\0', à
+//    *sptr, sa longueur à *lenptr, sa valeur de hachage à *hashptr, l'adresse
+//    et la longueur des données transmises à line_save lors de son
+//    enregistrement à *dataptr et *nptr, puis renvoie 1. Renvoie 0 si la fin
+//    de la section courante est atteinte, la lecture se poursuivant alors au
+//    début de la suivante, -1 si l'index est invalide ou ne contient plus de
+//    section.
+extern int snapshot_next(snapshot *s, char **sptr, size_t *lenptr,
+    size_t *hashptr, const void **dataptr, size_t *nptr);
+
+//  snapshot_dispose : sans effet si *sptr vaut NULL. Libère sinon les
+//    ressources allouées à la gestion de l'index associé à *sptr puis affecte
+//    NULL à *sptr.
+extern void snapshot_dispose(snapshot **sptr);
+
+//  snapshot_save : tente d'écrire un index de germe seed, de description des
+//    options options, portant sur les nbfile fichiers de noms filenames[0],
+//    ..., filenames[nbfile - 1] et d'informations infos[0], ...,
+//    infos[nbfile - 1], puis dont les lignes sont écrites par fill, appelée
+//    avec le contrôleur d'écriture et context, au moyen de snapshot_put_line,
+//    chaque section sauf la dernière étant terminée par snapshot_put_end.
+//    L'index est écrit dans un fichier temporaire qui ne remplace le fichier
+//    de nom fname qu'une fois complet. Renvoie une valeur non nulle si fill
+//    renvoie une valeur non nulle ou en cas d'erreur d'écriture ou de
+//    dépassement de capacité, zéro sinon.
+extern int snapshot_save(const char *fname, size_t seed, const char *options,
+    size_t nbfile, char **filenames, const fileinfo *infos,
+    int (*fill)(output *out, void *context), void *context);
+
+//  snapshot_put_end : termine sur out la section de lignes courante.
+extern void snapshot_put_end(output *out);
+
+//  snapshot_put_line : écrit sur out la ligne s de longueur len, de valeur de
+//    hachage hashval, suivie des n octets data transmis par line_save.
+extern void snapshot_put_line(output *out, const char *s, size_t len,
+    size_t hashval, const void *data, size_t n);
+
+#endif
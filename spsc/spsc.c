@@ -0,0 +1,72 @@
+//  spsc.c : partie implantation d'un module de file bornée de références,
+//    sans verrou, à un producteur et un consommateur.
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "spsc.h"
+
+//  struct spsc, spsc : le tableau refs de longueur mask + 1, puissance de deux,
+//    mémorise circulairement les références. head est le nombre de
+//    références défilées depuis la création, tail celui des références
+//    enfilées ; ils ne sont modifiés respectivement que par le consommateur
+//    et le producteur, et sont placés sur des lignes de cache distinctes.
+struct spsc {
+  size_t mask;
+  void **refs;
+  _Alignas(64) atomic_size_t head;
+  _Alignas(64) atomic_size_t tail;
+};
+
+spsc *spsc_empty(size_t capacity) {
+  size_t n = 1;
+  while (n < capacity) {
+    if (n > SIZE_MAX / 2 / sizeof(void *)) {
+      return NULL;
+    }
+    n *= 2;
+  }
+  spsc *q = aligned_alloc(_Alignof(spsc), sizeof *q);
+  if (q == NULL) {
+    return NULL;
+  }
+  q->refs = malloc(n * sizeof(void *));
+  if (q->refs == NULL) {
+    free(q);
+    return NULL;
+  }
+  q->mask = n - 1;
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+  return q;
+}
+
+void spsc_dispose(spsc **qptr) {
+  if (*qptr == NULL) {
+    return;
+  }
+  free((*qptr)->refs);
+  free(*qptr);
+  *qptr = NULL;
+}
+
+int spsc_push(spsc *q, void *ref) {
+  size_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  size_t h = atomic_load_explicit(&q->head, memory_order_acquire);
+  if (t - h > q->mask) {
+    return -1;
+  }
+  q->refs[t & q->mask] = ref;
+  atomic_store_explicit(&q->tail, t + 1, memory_order_release);
+  return 0;
+}
+
+void *spsc_pop(spsc *q) {
+  size_t h = atomic_load_explicit(&q->head, memory_order_relaxed);
+  size_t t = atomic_load_explicit(&q->tail, memory_order_acquire);
+  if (h == t) {
+    return NULL;
+  }
+  void *ref = q->refs[h & q->mask];
+  atomic_store_explicit(&q->head, h + 1, memory_order_release);
+  return ref;
+}
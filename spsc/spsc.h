@@ -0,0 +1,47 @@
+//  spsc.h : partie interface d'un module de file bornée de références, sans
+//    verrou, partagée par exactement deux fils d'exécution : un producteur,
+//    seul à enfiler, et un consommateur, seul à défiler.
+
+#ifndef SPSC__H
+#define SPSC__H
+
+#include <stdlib.h>
+
+//  Fonctionnement général :
+//  - la structure de données ne stocke pas d'objets mais des références vers
+//      ces objets. Les références sont du type générique « void * » ;
+//  - les fonctions qui possèdent un paramètre de type « spsc * » ou
+//      « spsc ** » ont un comportement indéterminé lorsque ce paramètre ou sa
+//      déréférence n'est pas l'adresse d'un contrôleur préalablement renvoyée
+//      avec succès par la fonction spsc_empty et non révoquée depuis par la
+//      fonction spsc_dispose ;
+//  - aucune fonction ne peut enfiler NULL ;
+//  - spsc_push ne doit être appelée que par un seul fil d'exécution et
+//      spsc_pop que par un seul autre. Les écritures effectuées par le
+//      producteur avant d'enfiler une référence sont visibles par le
+//      consommateur après qu'il l'a défilée.
+
+//  struct spsc, spsc : type et nom de type d'un contrôleur regroupant les
+//    informations nécessaires pour gérer une file.
+typedef struct spsc spsc;
+
+//  spsc_empty : tente d'allouer les ressources nécessaires pour gérer une
+//    nouvelle file initialement vide pouvant contenir au moins capacity
+//    références. Renvoie NULL en cas de dépassement de capacité. Renvoie
+//    sinon un pointeur vers le contrôleur associé à la file.
+extern spsc *spsc_empty(size_t capacity);
+
+//  spsc_dispose : sans effet si *qptr vaut NULL. Libère sinon les ressources
+//    allouées à la gestion de la file associée à *qptr puis affecte NULL à
+//    *qptr.
+extern void spsc_dispose(spsc **qptr);
+
+//  spsc_push : tente d'enfiler ref dans la file associée à q. Renvoie une
+//    valeur non nulle si la file est pleine, zéro sinon.
+extern int spsc_push(spsc *q, void *ref);
+
+//  spsc_pop : renvoie NULL si la file associée à q est vide. Défile sinon la
+//    référence en tête et la renvoie.
+extern void *spsc_pop(spsc *q);
+
+#endif